@@ -0,0 +1,17 @@
+#pragma once
+
+// A function computed over the rows of each group by hash_aggregate
+enum AggregateFunction
+{
+    COUNT_AGGREGATE, // The number of rows
+    MIN_AGGREGATE,
+    MAX_AGGREGATE,
+    SUM_AGGREGATE // Of integers, using native forms where present
+};
+
+// An aggregate function of one input column, (ignored by COUNT_AGGREGATE)
+struct Aggregate
+{
+    AggregateFunction function;
+    unsigned column;
+};
@@ -0,0 +1,57 @@
+#include "Column.h"
+#include "Dictionary.h"
+
+unsigned long Column::size() const
+{
+    return _dictionary == NULL ? _values.size() : _codes.size();
+}
+
+const string &Column::value(unsigned long i) const
+{
+    return _dictionary == NULL ? _values[i] : _dictionary->value(_codes[i]);
+}
+
+unsigned Column::code(unsigned long i) const
+{
+    return _dictionary == NULL ? Dictionary::NO_CODE : _codes[i];
+}
+
+long Column::native(unsigned long i) const
+{
+    return _type == STRING_COLUMN ? NO_NATIVE : _natives[i];
+}
+
+const Dictionary *Column::dictionary() const
+{
+    return _dictionary;
+}
+
+void Column::append(const string &value, long native)
+{
+    if (_type != STRING_COLUMN) {
+        _natives.emplace_back(native);
+    }
+    if (_dictionary == NULL) {
+        _values.emplace_back(value);
+    } else {
+        _codes.emplace_back(_dictionary->encode(value));
+    }
+}
+
+void Column::encode(Dictionary *dictionary)
+{
+    if (_dictionary == NULL) {
+        _dictionary = dictionary;
+        _codes.reserve(_values.size());
+        for (const string& value : _values) {
+            _codes.emplace_back(_dictionary->encode(value));
+        }
+        _values.clear();
+        _values.shrink_to_fit();
+    }
+}
+
+Column::Column(ColumnType type)
+    : _type(type),
+      _dictionary(NULL)
+{}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ColumnNames.h"
+
+using namespace std;
+
+class Dictionary;
+
+// The values of one column of a Table with COLUMN_STORAGE, in row order. The values are either stored as strings,
+// or, once the Column is encoded, as codes of a Dictionary. The values of a typed column are also stored in native
+// form.
+class Column
+{
+public:
+    // The number of values in this Column
+    unsigned long size() const;
+
+    // The i-th value of this Column
+    const string &value(unsigned long i) const;
+
+    // The dictionary code of the i-th value of this Column, or Dictionary::NO_CODE if this Column is not encoded
+    unsigned code(unsigned long i) const;
+
+    // The native form of the i-th value of this Column, or NO_NATIVE if this is a STRING_COLUMN
+    long native(unsigned long i) const;
+
+    // This Column's Dictionary, or NULL if this Column is not encoded
+    const Dictionary *dictionary() const;
+
+    // Append a value, with the given native form, to this Column
+    void append(const string &value, long native = NO_NATIVE);
+
+    // Replace this Column's values by their codes in the given dictionary. Values appended later are encoded too.
+    void encode(Dictionary *dictionary);
+
+    Column(ColumnType type);
+
+private:
+    ColumnType _type;
+    vector<string> _values;
+    vector<long> _natives;
+    vector<unsigned> _codes;
+    Dictionary *_dictionary;
+};
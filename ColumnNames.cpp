@@ -1,4 +1,39 @@
+#include <cerrno>
+#include <cstdlib>
 #include "ColumnNames.h"
+#include "dbexceptions.h"
+
+bool parse_native(ColumnType type, const string &value, long &native)
+{
+    native = NO_NATIVE;
+    if (type == INTEGER_COLUMN) {
+        const char *start = value.c_str();
+        char *end;
+        errno = 0;
+        native = strtol(start, &end, 10);
+        return end != start && *end == 0 && errno == 0 && native != NO_NATIVE;
+    } else if (type == DATE_COLUMN) {
+        bool valid = value.size() == 10 && value[4] == '/' && value[7] == '/';
+        native = 0;
+        for (unsigned i = 0; valid && i < value.size(); i++) {
+            if (i != 4 && i != 7) {
+                valid = value[i] >= '0' && value[i] <= '9';
+                native = native * 10 + (value[i] - '0');
+            }
+        }
+        return valid;
+    }
+    return true;
+}
+
+long native_value(ColumnType type, const string &value)
+{
+    long native;
+    if (!parse_native(type, value, native)) {
+        throw TableException(type == INTEGER_COLUMN ? "Invalid integer" : "Invalid date");
+    }
+    return native;
+}
 
 int ColumnNames::position(const string &name) const
 {
@@ -11,6 +46,31 @@ int ColumnNames::position(const string &name) const
     return -1;
 }
 
+ColumnType ColumnNames::type(unsigned position) const
+{
+    return _types.at(position);
+}
+
+bool ColumnNames::typed() const
+{
+    for (ColumnType type : _types) {
+        if (type != STRING_COLUMN) {
+            return true;
+        }
+    }
+    return false;
+}
+
 ColumnNames::ColumnNames(const initializer_list<string>& elements)
-        : vector<string>(elements)
+        : vector<string>(elements),
+          _types(elements.size(), STRING_COLUMN)
 {}
+
+ColumnNames::ColumnNames(const initializer_list<string>& elements, const initializer_list<ColumnType>& types)
+        : vector<string>(elements),
+          _types(types)
+{
+    if (_types.size() != size()) {
+        throw TableException("Column types don't match columns");
+    }
+}
@@ -1,15 +1,48 @@
 #pragma once
 
+#include <climits>
 #include <vector>
 #include <string>
 #include <initializer_list>
 
 using namespace std;
 
+// The type of a column's values. Values of INTEGER_COLUMN and DATE_COLUMN columns are parsed when they are added to a
+// table, and their native form is used for comparisons.
+enum ColumnType
+{
+    STRING_COLUMN,
+    INTEGER_COLUMN,
+    DATE_COLUMN // yyyy/mm/dd
+};
+
+// Indicates a value without a native form
+const long NO_NATIVE = LONG_MIN;
+
+// The native form of a value of the given type: the integer for INTEGER_COLUMN, yyyymmdd for DATE_COLUMN, and
+// NO_NATIVE for STRING_COLUMN. Throws TableException if the value is malformed.
+long native_value(ColumnType type, const string &value);
+
+// Set native to the native form of a value of the given type, as for native_value, returning false instead of
+// throwing if the value is malformed
+bool parse_native(ColumnType type, const string &value, long &native);
+
 class ColumnNames : public vector<string>
 {
 public:
     int position(const string &name) const;
 
+    // The type of the column at the given position
+    ColumnType type(unsigned position) const;
+
+    // True if any column is not a STRING_COLUMN
+    bool typed() const;
+
+    // Columns of type STRING_COLUMN
     ColumnNames(const initializer_list<string>& elements);
+
+    ColumnNames(const initializer_list<string>& elements, const initializer_list<ColumnType>& types);
+
+private:
+    vector<ColumnType> _types;
 };
@@ -27,6 +27,10 @@ unsigned ColumnSelector::unselected(int i) const
 }
 
 ColumnSelector::ColumnSelector(unsigned n_columns, const initializer_list<unsigned>& selected_positions)
+    : ColumnSelector(n_columns, vector<unsigned>(selected_positions))
+{}
+
+ColumnSelector::ColumnSelector(unsigned n_columns, const vector<unsigned>& selected_positions)
     : _n_columns(n_columns),
       _n_selected((unsigned) selected_positions.size()),
       _n_unselected(_n_columns - _n_selected),
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <initializer_list>
+#include <vector>
 
 using namespace std;
 
@@ -13,6 +14,7 @@ public:
     unsigned selected(int i) const;
     unsigned unselected(int i) const;
     ColumnSelector(unsigned n_columns, const initializer_list<unsigned>& selected_positions);
+    ColumnSelector(unsigned n_columns, const vector<unsigned>& selected_positions);
     virtual ~ColumnSelector();
 
 private:
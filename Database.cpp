@@ -2,13 +2,14 @@
 #include "Database.h"
 
 unordered_map<string, Table*> Database::_tables;
+Dictionary Database::_dictionary;
 
-Table* Database::new_table(const string &name, const ColumnNames &columns)
+Table* Database::new_table(const string &name, const ColumnNames &columns, TableStorage storage)
 {
     if (_tables.find(name) != _tables.end()) {
         throw TableException("Table name already in use");
     }
-    auto table = new Table(name, columns);
+    auto table = new Table(name, columns, storage);
     _tables.insert({{name, table}});
     return table;
 }
@@ -20,4 +21,10 @@ void Database::delete_all()
         delete i++->second;
     }
     _tables.clear();
+    _dictionary.clear();
+}
+
+Dictionary* Database::dictionary()
+{
+    return &_dictionary;
 }
@@ -7,6 +7,7 @@
 #include "Row.h"
 #include "ColumnNames.h"
 #include "ColumnSelector.h"
+#include "Dictionary.h"
 #include "QueryProcessor.h"
 #include "dbexceptions.h"
 
@@ -15,12 +16,16 @@ class Iterator;
 class Database
 {
 public:
-    // Returns a new, empty table, with the given name, and column names.
-    static Table* new_table(const string &name, const ColumnNames &columns);
+    // Returns a new, empty table, with the given name, column names, and storage.
+    static Table* new_table(const string &name, const ColumnNames &columns, TableStorage storage = ROW_STORAGE);
 
     // Delete all tables and rows, resulting an an empty database.
     static void delete_all();
 
+    // The Dictionary shared by all dictionary-encoded columns, so that codes from different tables can be compared.
+    static Dictionary* dictionary();
+
 private:
     static unordered_map<string, Table*> _tables;
+    static Dictionary _dictionary;
 };
@@ -0,0 +1,37 @@
+#include "Dictionary.h"
+
+const unsigned Dictionary::NO_CODE;
+
+unsigned Dictionary::encode(const string &value)
+{
+    auto inserted = _codes.insert(make_pair(value, (unsigned) _values.size()));
+    if (inserted.second) {
+        _values.emplace_back(&inserted.first->first);
+    }
+    return inserted.first->second;
+}
+
+unsigned Dictionary::code(const string &value) const
+{
+    auto code = _codes.find(value);
+    return code == _codes.end() ? NO_CODE : code->second;
+}
+
+const string &Dictionary::value(unsigned code) const
+{
+    return *_values[code];
+}
+
+unsigned long Dictionary::size() const
+{
+    return _values.size();
+}
+
+void Dictionary::clear()
+{
+    _codes.clear();
+    _values.clear();
+}
+
+Dictionary::Dictionary()
+{}
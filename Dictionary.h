@@ -0,0 +1,39 @@
+#pragma once
+
+#include <climits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// A mapping between strings and integer codes. Equal strings have equal codes, so comparing codes for equality is
+// the same as comparing the strings they encode.
+class Dictionary
+{
+public:
+    // The code for value, adding value to this Dictionary if it is not already present
+    unsigned encode(const string &value);
+
+    // The code for value, or NO_CODE if value is not present
+    unsigned code(const string &value) const;
+
+    // The value encoded by code
+    const string &value(unsigned code) const;
+
+    // The number of values in this Dictionary
+    unsigned long size() const;
+
+    // Remove all values from this Dictionary
+    void clear();
+
+    Dictionary();
+
+public:
+    static const unsigned NO_CODE = UINT_MAX;
+
+private:
+    unordered_map<string, unsigned> _codes;
+    // Keys of _codes, by code
+    vector<const string*> _values;
+};
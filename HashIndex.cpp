@@ -0,0 +1,25 @@
+#include "HashIndex.h"
+
+size_t HashIndexKeyHash::operator()(const Row& key) const
+{
+    size_t hash = 0;
+    unsigned n = (unsigned) key.size();
+    for (unsigned i = 0; i < n; i++) {
+        hash = hash * 31 + key.hash(i);
+    }
+    return hash;
+}
+
+bool HashIndexKeyEqual::operator()(const Row& x, const Row& y) const
+{
+    return x.equal(&y);
+}
+
+void HashIndex::put(const Row& key, Row* value)
+{
+    insert(make_pair(key, value));
+}
+
+HashIndex::HashIndex(Table* table, const vector<unsigned>& key_columns)
+    : IndexColumns(table, key_columns)
+{}
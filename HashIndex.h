@@ -0,0 +1,29 @@
+#pragma once
+
+#include <unordered_map>
+#include "Index.h"
+
+using namespace std;
+
+// Hashes index keys consistently with HashIndexKeyEqual, (see Row::hash)
+class HashIndexKeyHash
+{
+public:
+    size_t operator()(const Row& key) const;
+};
+
+// Compares index keys for equality column by column, as for Row::equal
+class HashIndexKeyEqual
+{
+public:
+    bool operator()(const Row& x, const Row& y) const;
+};
+
+// An index supporting only lookups of complete keys, in expected constant time. Use Index for range and prefix
+// lookups.
+class HashIndex: public unordered_multimap<Row, Row*, HashIndexKeyHash, HashIndexKeyEqual>, public IndexColumns
+{
+public:
+    void put(const Row& key, Row* value);
+    HashIndex(Table* table, const vector<unsigned>& key_columns);
+};
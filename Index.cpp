@@ -1,16 +1,332 @@
+#include <algorithm>
+#include <iterator>
 #include "Table.h"
 #include "Index.h"
+#include "Dictionary.h"
+#include "Parallel.h"
 
-void Index::put(const vector<string>& key, Row* value)
+bool IndexKeyCompare::operator()(const Row& x, const Row& y) const
 {
-    insert(make_pair(key, value));
+    // If one key is shorter, then it is compared as a prefix of the other.
+    unsigned n = (unsigned) min(x.size(), y.size());
+    for (unsigned i = 0; i < n; i++) {
+        int comparison = x.compare(i, &y, i);
+        if (comparison != 0) {
+            return comparison < 0;
+        }
+    }
+    return false;
 }
 
-unsigned Index::n_columns()
+unsigned IndexColumns::n_columns()
 {
     return _n_columns;
 }
 
-Index::Index(Table* table)
-    : _n_columns((unsigned) table->columns().size())
+const vector<unsigned>& IndexColumns::key_columns()
+{
+    return _key_columns;
+}
+
+Row IndexColumns::key(const vector<string>& values) const
+{
+    Row key;
+    unsigned n = (unsigned) min(values.size(), _key_types.size());
+    for (unsigned i = 0; i < n; i++) {
+        const string& value = values.at(i);
+        key.append(value, Dictionary::NO_CODE, native_value(_key_types.at(i), value));
+    }
+    return key;
+}
+
+Row IndexColumns::key(const Row* row) const
+{
+    Row key;
+    key.reserve(_key_columns.size());
+    for (unsigned column : _key_columns) {
+        key.append(row, column);
+    }
+    return key;
+}
+
+IndexColumns::IndexColumns(Table* table, const vector<unsigned>& key_columns)
+    : _n_columns((unsigned) table->columns().size()),
+      _key_columns(key_columns)
+{
+    for (unsigned column : key_columns) {
+        _key_types.emplace_back(table->columns().type(column));
+    }
+}
+
+// A B+-tree node. In a leaf, entries holds the keys and their rows, and next links to the following leaf. In an
+// interior node, children[i] holds the keys between keys[i - 1] and keys[i], (inclusive, since equal keys may
+// span nodes), and entries is empty.
+struct Index::Node
+{
+    bool is_leaf;
+    vector<Entry> entries;
+    vector<Row> keys;
+    vector<Node*> children;
+    Node* next;
+
+    explicit Node(bool is_leaf)
+        : is_leaf(is_leaf),
+          next(NULL)
+    {
+        if (is_leaf) {
+            entries.reserve(NODE_SIZE + 1);
+        } else {
+            keys.reserve(NODE_SIZE + 1);
+            children.reserve(NODE_SIZE + 2);
+        }
+    }
+};
+
+const Index::Entry& Index::iterator::operator*() const
+{
+    return _leaf->entries[_position];
+}
+
+const Index::Entry* Index::iterator::operator->() const
+{
+    return &_leaf->entries[_position];
+}
+
+Index::iterator& Index::iterator::operator++()
+{
+    if (++_position == _leaf->entries.size()) {
+        _leaf = _leaf->next;
+        _position = 0;
+    }
+    return *this;
+}
+
+Index::iterator Index::iterator::operator++(int)
+{
+    iterator current = *this;
+    ++(*this);
+    return current;
+}
+
+bool Index::iterator::operator==(const iterator& other) const
+{
+    return _leaf == other._leaf && _position == other._position;
+}
+
+bool Index::iterator::operator!=(const iterator& other) const
+{
+    return !(*this == other);
+}
+
+Index::iterator::iterator()
+    : _leaf(NULL),
+      _position(0)
 {}
+
+Index::iterator::iterator(const Node* leaf, unsigned position)
+    : _leaf(leaf),
+      _position(position)
+{
+    // Positions past the end of a leaf are at the start of the following leaf.
+    if (_leaf != NULL && _position == _leaf->entries.size()) {
+        _leaf = _leaf->next;
+        _position = 0;
+    }
+}
+
+void Index::put(const Row& key, Row* value)
+{
+    Row separator;
+    Node* sibling = insert(_root, key, value, separator);
+    if (sibling != NULL) {
+        Node* root = new Node(false);
+        root->keys.emplace_back(move(separator));
+        root->children.emplace_back(_root);
+        root->children.emplace_back(sibling);
+        _root = root;
+    }
+    _size++;
+}
+
+void Index::put(vector<Entry>& entries, unsigned n_threads)
+{
+    parallel_stable_sort(entries.begin(), entries.end(),
+                         [this](const Entry& x, const Entry& y) {
+                             return _compare(x.first, y.first);
+                         },
+                         n_threads);
+    if (_size == 0) {
+        build(entries);
+    } else {
+        for (const Entry& entry : entries) {
+            put(entry.first, entry.second);
+        }
+    }
+}
+
+void Index::put(const RowList& rows, unsigned n_threads)
+{
+    vector<Entry> entries(rows.size());
+    parallel_for(rows.size(), n_threads, [&](unsigned long begin, unsigned long end) {
+        for (unsigned long i = begin; i < end; i++) {
+            entries[i].first = key(rows[i]);
+            entries[i].second = rows[i];
+        }
+    });
+    put(entries, n_threads);
+}
+
+unsigned long Index::size() const
+{
+    return _size;
+}
+
+Index::iterator Index::begin() const
+{
+    const Node* node = _root;
+    while (!node->is_leaf) {
+        node = node->children.front();
+    }
+    return iterator(node, 0);
+}
+
+Index::iterator Index::end() const
+{
+    return iterator();
+}
+
+Index::iterator Index::lower_bound(const Row& key) const
+{
+    const Node* leaf = this->leaf(key, false);
+    auto position = std::lower_bound(leaf->entries.begin(), leaf->entries.end(), key,
+                                     [this](const Entry& entry, const Row& key) {
+                                         return _compare(entry.first, key);
+                                     });
+    return iterator(leaf, (unsigned) (position - leaf->entries.begin()));
+}
+
+Index::iterator Index::upper_bound(const Row& key) const
+{
+    const Node* leaf = this->leaf(key, true);
+    auto position = std::upper_bound(leaf->entries.begin(), leaf->entries.end(), key,
+                                     [this](const Row& key, const Entry& entry) {
+                                         return _compare(key, entry.first);
+                                     });
+    return iterator(leaf, (unsigned) (position - leaf->entries.begin()));
+}
+
+Index::Node* Index::insert(Node* node, const Row& key, Row* value, Row& separator)
+{
+    // Equal keys are inserted after those already present, as for upper_bound.
+    Node* sibling = NULL;
+    if (node->is_leaf) {
+        auto position = std::upper_bound(node->entries.begin(), node->entries.end(), key,
+                                         [this](const Row& key, const Entry& entry) {
+                                             return _compare(key, entry.first);
+                                         });
+        node->entries.emplace(position, key, value);
+        if (node->entries.size() > NODE_SIZE) {
+            sibling = new Node(true);
+            auto middle = node->entries.begin() + node->entries.size() / 2;
+            move(middle, node->entries.end(), back_inserter(sibling->entries));
+            node->entries.erase(middle, node->entries.end());
+            sibling->next = node->next;
+            node->next = sibling;
+            separator = sibling->entries.front().first;
+        }
+    } else {
+        auto child_position = std::upper_bound(node->keys.begin(), node->keys.end(), key, _compare);
+        unsigned child = (unsigned) (child_position - node->keys.begin());
+        Row child_separator;
+        Node* child_sibling = insert(node->children[child], key, value, child_separator);
+        if (child_sibling != NULL) {
+            node->keys.emplace(node->keys.begin() + child, move(child_separator));
+            node->children.emplace(node->children.begin() + child + 1, child_sibling);
+            if (node->keys.size() > NODE_SIZE) {
+                // The middle key moves up, separating the remaining keys of node and sibling.
+                sibling = new Node(false);
+                unsigned middle = (unsigned) node->keys.size() / 2;
+                separator = move(node->keys[middle]);
+                move(node->keys.begin() + middle + 1, node->keys.end(), back_inserter(sibling->keys));
+                sibling->children.assign(node->children.begin() + middle + 1, node->children.end());
+                node->keys.erase(node->keys.begin() + middle, node->keys.end());
+                node->children.erase(node->children.begin() + middle + 1, node->children.end());
+            }
+        }
+    }
+    return sibling;
+}
+
+void Index::build(vector<Entry>& entries)
+{
+    if (entries.empty()) {
+        return;
+    }
+    // Fill the leaves, and then each level of interior nodes, from left to right. Each node is paired with the
+    // smallest key in its subtree, which separates it from its left sibling in their parent.
+    vector<pair<Node*, const Row*>> level;
+    Node* leaf = NULL;
+    for (Entry& entry : entries) {
+        if (leaf == NULL || leaf->entries.size() == NODE_SIZE) {
+            Node* previous = leaf;
+            leaf = new Node(true);
+            if (previous != NULL) {
+                previous->next = leaf;
+            }
+        }
+        leaf->entries.emplace_back(move(entry));
+        if (leaf->entries.size() == 1) {
+            level.emplace_back(leaf, &leaf->entries.front().first);
+        }
+    }
+    while (level.size() > 1) {
+        vector<pair<Node*, const Row*>> parents;
+        for (auto& child : level) {
+            Node* parent = parents.empty() ? NULL : parents.back().first;
+            if (parent == NULL || parent->children.size() == NODE_SIZE + 1) {
+                parent = new Node(false);
+                parents.emplace_back(parent, child.second);
+            } else {
+                parent->keys.emplace_back(*child.second);
+            }
+            parent->children.emplace_back(child.first);
+        }
+        level.swap(parents);
+    }
+    destroy(_root);
+    _root = level.front().first;
+    _size = entries.size();
+}
+
+const Index::Node* Index::leaf(const Row& key, bool upper) const
+{
+    // Descend to the leaf in which a lower_bound (or upper_bound) search for key starts. If the search reaches
+    // the end of that leaf, it continues at the start of the next.
+    const Node* node = _root;
+    while (!node->is_leaf) {
+        auto position = upper
+                        ? std::upper_bound(node->keys.begin(), node->keys.end(), key, _compare)
+                        : std::lower_bound(node->keys.begin(), node->keys.end(), key, _compare);
+        node = node->children[position - node->keys.begin()];
+    }
+    return node;
+}
+
+void Index::destroy(Node* node)
+{
+    for (Node* child : node->children) {
+        destroy(child);
+    }
+    delete node;
+}
+
+Index::Index(Table* table, const vector<unsigned>& key_columns)
+    : IndexColumns(table, key_columns),
+      _root(new Node(true)),
+      _size(0)
+{}
+
+Index::~Index()
+{
+    destroy(_root);
+}
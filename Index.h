@@ -1,21 +1,109 @@
 #pragma once
 
-#include <map>
+#include <utility>
+#include <string>
 #include <vector>
+#include "Row.h"
 
 using namespace std;
 
-class Row;
-
 class Table;
 
-class Index: public map<vector<string>, Row*>
+// Orders index keys column by column, comparing native forms of typed values
+class IndexKeyCompare
+{
+public:
+    bool operator()(const Row& x, const Row& y) const;
+};
+
+// The key columns of an index on a table, shared by Index and HashIndex
+class IndexColumns
 {
 public:
-    void put(const vector<string>& key, Row* value);
     unsigned n_columns();
-    Index(Table* table);
+    // Positions of the key columns in the indexed table
+    const vector<unsigned>& key_columns();
+    // A key, for lookups in this index, with the given values of the key columns
+    Row key(const vector<string>& values) const;
+    // The key of the given row of the indexed table
+    Row key(const Row* row) const;
+
+protected:
+    IndexColumns(Table* table, const vector<unsigned>& key_columns);
 
 private:
     unsigned _n_columns;
+    vector<unsigned> _key_columns;
+    vector<ColumnType> _key_types;
+};
+
+// An ordered index, mapping keys to rows of a table. Rows with equal keys are kept in the order in which they
+// were put. The index is a B+-tree: nodes hold up to NODE_SIZE keys in contiguous arrays, and the leaves are
+// linked, so that a range scan, after one descent, reads the entries in order, leaf by leaf.
+class Index: public IndexColumns
+{
+private:
+    struct Node;
+
+public:
+    typedef pair<Row, Row*> Entry;
+
+    // A position in the index. Incrementing an iterator moves to the following entry, in key order.
+    class iterator
+    {
+    public:
+        const Entry& operator*() const;
+        const Entry* operator->() const;
+        iterator& operator++();
+        iterator operator++(int);
+        bool operator==(const iterator& other) const;
+        bool operator!=(const iterator& other) const;
+        iterator();
+
+    private:
+        iterator(const Node* leaf, unsigned position);
+
+    private:
+        const Node* _leaf; // NULL at the end of the index
+        unsigned _position;
+
+        friend class Index;
+    };
+
+public:
+    void put(const Row& key, Row* value);
+    // Put the given entries, as if one at a time, in order. The entries are sorted first, using n_threads threads.
+    // If this index is empty, it is then built bottom-up, moving the entries into full leaves. Otherwise, the
+    // entries are inserted in sorted order, so that consecutive insertions visit the same or neighbouring leaves.
+    void put(vector<Entry>& entries, unsigned n_threads = 1);
+    // Put the given rows of the indexed table, as above, with their keys extracted using n_threads threads
+    void put(const RowList& rows, unsigned n_threads = 1);
+    // The number of entries in the index
+    unsigned long size() const;
+    iterator begin() const;
+    iterator end() const;
+    // The first entry whose key is not less than key
+    iterator lower_bound(const Row& key) const;
+    // The first entry whose key is greater than key
+    iterator upper_bound(const Row& key) const;
+    Index(Table* table, const vector<unsigned>& key_columns);
+    ~Index();
+
+public:
+    // The maximum number of keys in a node
+    static const unsigned NODE_SIZE = 64;
+
+private:
+    // Insert the entry into the subtree rooted at node, returning a new right sibling of node if node had to be
+    // split, (with the smallest key of the new sibling's subtree in separator), or NULL otherwise.
+    Node* insert(Node* node, const Row& key, Row* value, Row& separator);
+    // Replace the (empty) tree by one containing the given sorted entries
+    void build(vector<Entry>& entries);
+    const Node* leaf(const Row& key, bool upper) const;
+    static void destroy(Node* node);
+
+private:
+    Node* _root;
+    unsigned long _size;
+    IndexKeyCompare _compare;
 };
@@ -0,0 +1,35 @@
+#include "Iterator.h"
+#include "Row.h"
+
+unsigned Iterator::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    Row* row;
+    while (!batch.full() && (row = next()) != NULL) {
+        batch.emplace_back(row);
+    }
+    return (unsigned) batch.size();
+}
+
+const RowView* Iterator::next_view()
+{
+    Row::reclaim(_view_row);
+    _view.clear();
+    _view_row = next();
+    if (_view_row == NULL) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < _view_row->size(); i++) {
+        _view.append(_view_row, i);
+    }
+    return &_view;
+}
+
+Iterator::Iterator()
+    : _view_row(NULL)
+{}
+
+Iterator::~Iterator()
+{
+    Row::reclaim(_view_row);
+}
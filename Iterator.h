@@ -1,6 +1,9 @@
 #pragma once
 
+#include "RowView.h"
+
 class Row;
+class RowBatch;
 
 class Iterator
 {
@@ -8,6 +11,29 @@ public:
     virtual unsigned n_columns() = 0;
     virtual void open() = 0;
     virtual Row* next() = 0;
+    // Replace the contents of batch by up to batch.size_limit() of the following rows, returning the number of
+    // rows in the batch. 0 is returned at the end of the input. Rows are owned as for next(). This default
+    // implementation calls next() for each row.
+    virtual unsigned next_batch(RowBatch& batch);
+    // A view of the next row, or NULL at the end of the input. The view, and the rows it refers to, belong to this
+    // Iterator, and remain valid until the following call of next_view() or close(). Callers that keep the row
+    // must materialize it. This default implementation returns a view of the row returned by next(), reclaiming
+    // it on the following call.
+    virtual const RowView* next_view();
     virtual void close() = 0;
-    virtual ~Iterator() {}
+    virtual ~Iterator();
+
+protected:
+    Iterator();
+
+protected:
+    // The view returned by next_view()
+    RowView _view;
+
+private:
+    // The row viewed by the default next_view()
+    Row* _view_row;
 };
+
+// Builds a plan over the given input, e.g. to be run by each thread of a parallel_scan
+typedef Iterator* (*Pipeline)(Iterator* input);
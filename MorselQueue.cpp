@@ -0,0 +1,54 @@
+#include <algorithm>
+#include "MorselQueue.h"
+
+bool MorselQueue::next(unsigned worker, unsigned long& begin, unsigned long& end)
+{
+    unsigned long morsel;
+    bool found = take(worker, false, morsel);
+    unsigned n = n_workers();
+    for (unsigned i = 1; !found && i < n; i++) {
+        found = take((worker + i) % n, true, morsel);
+    }
+    if (found) {
+        begin = morsel * _morsel_size;
+        end = min(begin + _morsel_size, _n_rows);
+    }
+    return found;
+}
+
+void MorselQueue::reset(unsigned long n_rows)
+{
+    _n_rows = n_rows;
+    unsigned long n_morsels = (_n_rows + _morsel_size - 1) / _morsel_size;
+    unsigned n = n_workers();
+    for (unsigned i = 0; i < n; i++) {
+        Share& share = _shares[i];
+        lock_guard<mutex> guard(share.lock);
+        share.first = n_morsels * i / n;
+        share.last = n_morsels * (i + 1) / n;
+    }
+}
+
+unsigned MorselQueue::n_workers() const
+{
+    return (unsigned) _shares.size();
+}
+
+MorselQueue::MorselQueue(unsigned long morsel_size, unsigned n_workers)
+    : _n_rows(0),
+      _morsel_size(max(1UL, morsel_size)),
+      _shares(max(1U, n_workers))
+{
+    reset(0);
+}
+
+bool MorselQueue::take(unsigned worker, bool steal, unsigned long& morsel)
+{
+    Share& share = _shares[worker];
+    lock_guard<mutex> guard(share.lock);
+    if (share.first == share.last) {
+        return false;
+    }
+    morsel = steal ? --share.last : share.first++;
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// Divides the positions [0, n_rows) of a table, given by reset(), into morsels, of up to morsel_size consecutive
+// positions, to be scanned by a number of workers. Each worker starts with its own contiguous share of the morsels,
+// and takes them in order. A worker whose share is exhausted steals the last remaining morsel of another worker, so
+// that workers finishing early help those that are slowed by skew.
+class MorselQueue
+{
+public:
+    // Set [begin, end) to the next morsel for the given worker, returning false if there are no morsels left
+    bool next(unsigned worker, unsigned long& begin, unsigned long& end);
+
+    // Hand out the morsels of [0, n_rows), discarding any that remain
+    void reset(unsigned long n_rows);
+
+    unsigned n_workers() const;
+
+    MorselQueue(unsigned long morsel_size, unsigned n_workers);
+
+public:
+    static const unsigned long DEFAULT_MORSEL_SIZE = 10000;
+
+private:
+    // Take a morsel from the front of the worker's share, or if steal is true, from the back
+    bool take(unsigned worker, bool steal, unsigned long& morsel);
+
+private:
+    // The morsels of a worker's share that remain, [first, last)
+    struct Share
+    {
+        mutex lock;
+        unsigned long first;
+        unsigned long last;
+    };
+
+    unsigned long _n_rows;
+    unsigned long _morsel_size;
+    vector<Share> _shares;
+};
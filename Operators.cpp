@@ -2,16 +2,33 @@
 #include <algorithm>
 #include "QueryProcessor.h"
 #include "Table.h"
+#include "Database.h"
 #include "Index.h"
 #include "Iterator.h"
 #include "Row.h"
 #include "RowCompare.h"
 #include "ColumnSelector.h"
+#include "Dictionary.h"
 #include "Operators.h"
+#include "Parallel.h"
 #include "util.h"
 
 //----------------------------------------------------------------------
 
+// Materialize the row at the given position of a table with COLUMN_STORAGE, as an intermediate row.
+static Row* column_storage_row(const Table* table, unsigned long position)
+{
+    Row* row = Row::make_intermediate();
+    unsigned n = (unsigned) table->columns().size();
+    for (unsigned i = 0; i < n; i++) {
+        const Column& column = table->column(i);
+        row->append(column.value(position), column.code(position), column.native(position));
+    }
+    return row;
+}
+
+//----------------------------------------------------------------------
+
 // TableIterator 
 
 unsigned TableIterator::n_columns() 
@@ -23,329 +40,1981 @@ void TableIterator::open()
 {
     _input = _table->rows().begin();
     _end = _table->rows().end();
-    
+    _position = 0;
+    _n_rows = _table->n_rows();
 }
 
 Row* TableIterator::next() 
 {
     Row* next = NULL;
-    if (_input != _end) {
-        next = *(_input++);
+    if (_table->storage() == ROW_STORAGE) {
+        if (_input != _end) {
+            next = *(_input++);
+        }
+    } else if (_position < _n_rows) {
+        next = column_storage_row(_table, _position++);
     }
     return next;
 }   
 
+unsigned TableIterator::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    if (_table->storage() == ROW_STORAGE) {
+        while (_input != _end && !batch.full()) {
+            batch.emplace_back(*(_input++));
+        }
+    } else {
+        while (_position < _n_rows && !batch.full()) {
+            batch.emplace_back(column_storage_row(_table, _position++));
+        }
+    }
+    return (unsigned) batch.size();
+}
+
 void TableIterator::close() 
 {
     _input = _end;
+    _position = _n_rows;
 }
 
 TableIterator::TableIterator(Table* table)
-    : _table(table)
+    : _table(table),
+      _position(0),
+      _n_rows(0)
 {
 }
 
 //----------------------------------------------------------------------
 
-// IndexScan
+// ColumnScan
 
-unsigned IndexScan::n_columns()
+unsigned ColumnScan::n_columns()
 {
-    return _index->n_columns();
+    return (unsigned) _columns.size();
 }
 
-void IndexScan::open()
+void ColumnScan::open()
 {
-    _input = _index->lower_bound(*_lo);
-    _end = _index->upper_bound(*_hi);
+    const Dictionary* dictionary = _predicate_column == NULL ? NULL : _predicate_column->dictionary();
+    // If _value isn't in the dictionary, then it matches no code.
+    _value_code = dictionary == NULL ? Dictionary::NO_CODE : dictionary->code(_value);
+    _position = 0;
+    _n_rows = _table->n_rows();
 }
 
-
-Row* IndexScan::next()
+Row* ColumnScan::next()
 {
     Row* next = NULL;
-    if (_input != _end) {
-        next = (_input++)->second;
+    while (next == NULL && _position < _n_rows) {
+        unsigned long position = _position++;
+        if (selected(position)) {
+            next = materialize(position);
+        }
     }
     return next;
 }
 
-void IndexScan::close()
+unsigned ColumnScan::next_batch(RowBatch& batch)
 {
-    _input = _end;
+    batch.clear();
+    while (_position < _n_rows && !batch.full()) {
+        unsigned long position = _position++;
+        if (selected(position)) {
+            batch.emplace_back(materialize(position));
+        }
+    }
+    return (unsigned) batch.size();
 }
 
-IndexScan::IndexScan(Index* index, Row* lo, Row* hi)
-    : _index(index),
-      _lo(lo),
-      _hi(hi == NULL ? lo : hi)
-{}
+void ColumnScan::close()
+{
+    _position = _n_rows;
+}
+
+bool ColumnScan::selected(unsigned long position)
+{
+    // Only the predicate column is read, so rows that aren't selected are never materialized.
+    return
+        _predicate_column == NULL ? true :
+        _predicate != NULL ? _predicate(_predicate_column->value(position)) :
+        _predicate_column->dictionary() != NULL ? _predicate_column->code(position) == _value_code :
+        _predicate_column->value(position) == _value;
+}
+
+Row* ColumnScan::materialize(unsigned long position)
+{
+    Row* row = Row::make_intermediate();
+    for (const Column* column : _columns) {
+        row->append(column->value(position), column->code(position), column->native(position));
+    }
+    return row;
+}
+
+ColumnScan::ColumnScan(Table* table,
+                       const initializer_list<unsigned>& columns,
+                       int predicate_column,
+                       ValuePredicate predicate)
+    : _table(table),
+      _predicate_column(predicate == NULL ? NULL : &table->column((unsigned) predicate_column)),
+      _predicate(predicate),
+      _value_code(Dictionary::NO_CODE),
+      _position(0),
+      _n_rows(0)
+{
+    assert(table->storage() == COLUMN_STORAGE);
+    for (unsigned column : columns) {
+        _columns.emplace_back(&table->column(column));
+    }
+}
+
+ColumnScan::ColumnScan(Table* table,
+                       const initializer_list<unsigned>& columns,
+                       int predicate_column,
+                       const string& value)
+    : _table(table),
+      _predicate_column(&table->column((unsigned) predicate_column)),
+      _predicate(NULL),
+      _value(value),
+      _value_code(Dictionary::NO_CODE),
+      _position(0),
+      _n_rows(0)
+{
+    assert(table->storage() == COLUMN_STORAGE);
+    for (unsigned column : columns) {
+        _columns.emplace_back(&table->column(column));
+    }
+}
 
 //----------------------------------------------------------------------
 
-// Select
+// MorselScan
 
-unsigned Select::n_columns()
+unsigned MorselScan::n_columns()
 {
-    return _input->n_columns();
+    return _table->columns().size();
 }
 
-void Select::open()
+void MorselScan::open()
 {
-    _input->open();
+    _replayed = 0;
+    _position = 0;
+    _end = 0;
 }
 
-Row* Select::next()
+Row* MorselScan::next()
 {
-    Row* next = _input->next();
-    while (next != NULL && !_predicate(next)) {
-        Row::reclaim(next);
-        next = _input->next();
+    if (_position == _end && !next_morsel()) {
+        return NULL;
     }
-    return next;
+    return row(_position++);
 }
 
-void Select::close()
+unsigned MorselScan::next_batch(RowBatch& batch)
 {
-    _input->close();
+    batch.clear();
+    while (!batch.full() && (_position < _end || next_morsel())) {
+        batch.emplace_back(row(_position++));
+    }
+    return (unsigned) batch.size();
 }
 
-Select::Select(Iterator* input, RowPredicate predicate)
-    : _input(input),
-      _predicate(predicate)
+void MorselScan::close()
 {
+    _position = _end;
 }
 
-Select::~Select()
+void MorselScan::restart()
 {
-    delete _input;
+    _claimed.clear();
+    _replayed = 0;
+    _position = 0;
+    _end = 0;
+}
+
+// Start the next morsel: one claimed by an earlier pass, or else a new one
+bool MorselScan::next_morsel()
+{
+    if (_replayed == _claimed.size()) {
+        unsigned long begin;
+        unsigned long end;
+        if (!_morsels->next(_worker, begin, end)) {
+            return false;
+        }
+        _claimed.emplace_back(begin, end);
+    }
+    _position = _claimed[_replayed].first;
+    _end = _claimed[_replayed].second;
+    _replayed++;
+    return true;
+}
+
+Row* MorselScan::row(unsigned long position)
+{
+    return _table->storage() == ROW_STORAGE ? _table->rows()[position] : column_storage_row(_table, position);
 }
 
+MorselScan::MorselScan(Table* table, MorselQueue* morsels, unsigned worker)
+    : _table(table),
+      _morsels(morsels),
+      _worker(worker),
+      _replayed(0),
+      _position(0),
+      _end(0)
+{}
+
 //----------------------------------------------------------------------
 
-// Project
+// Gather
 
-unsigned Project::n_columns()
+unsigned Gather::n_columns()
 {
-    return _column_selector.n_selected();
+    return _pipelines.front()->n_columns();
 }
 
-void Project::open()
+void Gather::open()
 {
-    _input->open();
+    _closing = false;
+    _error = nullptr;
+    _n_running = (unsigned) _pipelines.size();
+    for (unsigned worker = 0; worker < _pipelines.size(); worker++) {
+        _workers.emplace_back(&Gather::work, this, worker);
+    }
 }
 
-Row* Project::next()
+Row* Gather::next()
 {
-    Row* projected = NULL;
-    Row* row = _input->next();
-    if (row) {
-        projected = new Row();
-        for (unsigned i = 0; i < _column_selector.n_selected(); i++) {
-            projected->append(row->at(_column_selector.selected(i)));
-        }
+    unique_lock<mutex> lock(_lock);
+    _produced.wait(lock, [this] { return !_rows.empty() || _n_running == 0 || _error; });
+    if (_error) {
+        rethrow_exception(_error);
+    }
+    Row* next = NULL;
+    if (!_rows.empty()) {
+        next = _rows.front();
+        _rows.pop_front();
+        _consumed.notify_all();
+    }
+    return next;
+}
+
+unsigned Gather::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    unique_lock<mutex> lock(_lock);
+    _produced.wait(lock, [this] { return !_rows.empty() || _n_running == 0 || _error; });
+    if (_error) {
+        rethrow_exception(_error);
+    }
+    while (!batch.full() && !_rows.empty()) {
+        batch.emplace_back(_rows.front());
+        _rows.pop_front();
+    }
+    _consumed.notify_all();
+    return (unsigned) batch.size();
+}
+
+void Gather::close()
+{
+    {
+        lock_guard<mutex> lock(_lock);
+        _closing = true;
+        _consumed.notify_all();
+    }
+    for (thread& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+    for (Row* row : _rows) {
         Row::reclaim(row);
     }
-    return projected;
+    _rows.clear();
 }
 
-void Project::close()
+void Gather::work(unsigned worker)
 {
-    _input->close();
+    Iterator* pipeline = _pipelines.at(worker);
+    RowBatch batch;
+    try {
+        pipeline->open();
+        while (pipeline->next_batch(batch) > 0 && deliver(batch)) {
+        }
+        pipeline->close();
+    } catch (...) {
+        // Keep the first error, for the consumer to rethrow, and stop the other workers.
+        {
+            lock_guard<mutex> lock(_lock);
+            if (!_error) {
+                _error = current_exception();
+            }
+            _closing = true;
+            _consumed.notify_all();
+        }
+        try {
+            pipeline->close();
+        } catch (...) {
+        }
+    }
+    lock_guard<mutex> lock(_lock);
+    _n_running--;
+    _produced.notify_all();
 }
 
-Project::Project(Iterator* input, const initializer_list<unsigned>& columns)
-    : _input(input),
-      _column_selector(input->n_columns(), columns)
+bool Gather::deliver(RowBatch& batch)
+{
+    unique_lock<mutex> lock(_lock);
+    _consumed.wait(lock, [this] { return _rows.size() < _capacity || _closing; });
+    if (_closing) {
+        lock.unlock();
+        for (Row* row : batch) {
+            Row::reclaim(row);
+        }
+        return false;
+    }
+    _rows.insert(_rows.end(), batch.begin(), batch.end());
+    _produced.notify_all();
+    return true;
+}
+
+void Gather::add_pipeline(Iterator* pipeline)
+{
+    _pipelines.emplace_back(pipeline);
+    _capacity = 2 * _pipelines.size() * RowBatch::DEFAULT_SIZE_LIMIT;
+}
+
+Gather::Gather()
+    : _capacity(0),
+      _n_running(0),
+      _closing(false)
 {}
 
-Project::~Project()
+Gather::~Gather()
 {
-    delete _input;
+    Gather::close();
+    for (Iterator* pipeline : _pipelines) {
+        delete pipeline;
+    }
 }
 
 //----------------------------------------------------------------------
 
-// NestedLoopsJoin
+// ParallelScan
 
-unsigned NestedLoopsJoin::n_columns()
+void ParallelScan::open()
 {
-    return _left_join_columns.n_columns() + _right_join_columns.n_unselected();
+    for (MorselScan* scan : _scans) {
+        scan->restart();
+    }
+    _morsels.reset(_table->n_rows());
+    Gather::open();
 }
 
-void NestedLoopsJoin::open()
+ParallelScan::ParallelScan(Table* table, unsigned n_threads, Pipeline pipeline, unsigned long morsel_size)
+    : _table(table),
+      _morsels(morsel_size, n_threads)
 {
-    _left->open();
-    _right->open();
-    _left_row = _left->next();
+    // Each worker's plan reads the morsels it claims.
+    for (unsigned worker = 0; worker < _morsels.n_workers(); worker++) {
+        MorselScan* scan = new MorselScan(table, &_morsels, worker);
+        _scans.emplace_back(scan);
+        add_pipeline(pipeline == NULL ? scan : pipeline(scan));
+    }
 }
 
-Row* NestedLoopsJoin::next()
+//----------------------------------------------------------------------
+
+// Exchange
+
+void Exchange::open()
 {
-    Row* right_row = _right->next();
-    while (_left_row != NULL && right_row != NULL && match(_left_row, right_row) == false) {
-        Row::reclaim(_left_row);
-        _left_row = _left->next();
-        if (_left_row == NULL) {
-            Row::reclaim(right_row);
-            right_row = _right->next();
-            if (right_row != NULL) {
-                _left->close();
-                _left->open();
-                _left_row = _left->next();
-            }
+    _input_done = false;
+    _input_error = nullptr;
+    _closing = false;
+    _distributor = thread(&Exchange::distribute, this);
+    Gather::open();
+}
+
+void Exchange::close()
+{
+    {
+        lock_guard<mutex> lock(_lock);
+        _closing = true;
+        _sent.notify_all();
+        _received.notify_all();
+    }
+    Gather::close();
+    if (_distributor.joinable()) {
+        _distributor.join();
+    }
+    for (ExchangePartition* partition : _partition_inputs) {
+        partition->restart();
+    }
+    for (deque<Row*>& partition : _partitions) {
+        for (Row* row : partition) {
+            Row::reclaim(row);
         }
+        partition.clear();
     }
+}
 
-    Row* next = NULL;
-    if (_left_row != NULL && right_row != NULL) {
-        next = join_rows(_left_row, right_row);
+void Exchange::distribute()
+{
+    unsigned n = (unsigned) _partitions.size();
+    vector<vector<Row*>> outputs(n);
+    RowBatch batch;
+    unsigned long n_batches = 0;
+    bool sending = true;
+    exception_ptr error;
+    try {
+        _input->open();
+        while (sending && _input->next_batch(batch) > 0) {
+            if (_partition_columns.empty()) {
+                outputs[n_batches++ % n].assign(batch.begin(), batch.end());
+            } else {
+                for (Row* row : batch) {
+                    outputs[partition(row)].emplace_back(row);
+                }
+            }
+            for (unsigned i = 0; sending && i < n; i++) {
+                sending = outputs[i].empty() || send(i, outputs[i]);
+            }
+        }
+        _input->close();
+    } catch (...) {
+        error = current_exception();
+        try {
+            _input->close();
+        } catch (...) {
+        }
     }
-    if (right_row != NULL) {
-        Row::reclaim(right_row);
+    for (vector<Row*>& output : outputs) {
+        for (Row* row : output) {
+            Row::reclaim(row);
+        }
     }
-    return next;
+    // The partitions end, and an error is rethrown by the workers receiving from them, (and so by the Exchange).
+    lock_guard<mutex> lock(_lock);
+    _input_error = error;
+    _input_done = true;
+    _sent.notify_all();
 }
 
-
-Row* NestedLoopsJoin::join_rows(const Row* left, const Row* right)
+unsigned Exchange::partition(const Row* row)
 {
-    Row* joined = new Row();
-    unsigned lcols = _left_join_columns.n_columns();
-    unsigned rcols = _right_join_columns.n_unselected();
-    for (unsigned i = 0; i < lcols; i++) {
-        joined->append(left->at(i));
-    }
-    for (unsigned i = 0; i < rcols; i++) {
-        joined->append(right->at(_right_join_columns.unselected(i)));
+    size_t hash = 0;
+    for (unsigned column : _partition_columns) {
+        hash = hash * 31 + row->hash(column);
     }
-    return joined;
+    return (unsigned) (hash % _partitions.size());
 }
 
-bool NestedLoopsJoin::match(const Row* left, const Row* right)
+bool Exchange::send(unsigned partition, vector<Row*>& rows)
 {
-    unsigned cols = _left_join_columns.n_selected();
-    for (unsigned i = 0, j = 0; i < cols; i++, j++) {
-        if (left->at(_left_join_columns.selected(i)) != right->at(_right_join_columns.selected(i))) {
-            return false;
-        }
+    unique_lock<mutex> lock(_lock);
+    deque<Row*>& queue = _partitions[partition];
+    _received.wait(lock, [&] { return queue.size() < _capacity || _closing; });
+    if (_closing) {
+        return false;
     }
+    queue.insert(queue.end(), rows.begin(), rows.end());
+    rows.clear();
+    _sent.notify_all();
     return true;
 }
 
-
-void NestedLoopsJoin::close()
+unsigned Exchange::receive(unsigned partition, RowBatch& batch)
 {
-    _left->close();
-    _right->close();
-    Row::reclaim(_left_row);
+    batch.clear();
+    unique_lock<mutex> lock(_lock);
+    deque<Row*>& queue = _partitions[partition];
+    _sent.wait(lock, [&] { return !queue.empty() || _input_done || _closing; });
+    if (_input_error) {
+        rethrow_exception(_input_error);
+    }
+    while (!_closing && !batch.full() && !queue.empty()) {
+        batch.emplace_back(queue.front());
+        queue.pop_front();
+    }
+    _received.notify_all();
+    return (unsigned) batch.size();
 }
 
-NestedLoopsJoin::NestedLoopsJoin(Iterator* left,
-                                 const initializer_list<unsigned>& left_join_columns,
-                                 Iterator* right,
-                                 const initializer_list<unsigned>& right_join_columns)
-    : _left(left),
-      _right(right),
-      _left_join_columns(left->n_columns(), left_join_columns),
-      _right_join_columns(right->n_columns(), right_join_columns),
-      _left_row(NULL)
+Exchange::Exchange(Iterator* input,
+                   unsigned n_threads,
+                   Pipeline pipeline,
+                   const initializer_list<unsigned>& partition_columns,
+                   bool rescannable)
+    : _input(input),
+      _partition_columns(partition_columns),
+      _partitions(max(1U, n_threads)),
+      _capacity(2 * RowBatch::DEFAULT_SIZE_LIMIT),
+      _input_done(false),
+      _closing(false)
 {
-    assert(_left_join_columns.n_selected() == _right_join_columns.n_selected());
+    for (unsigned column : _partition_columns) {
+        assert(column < input->n_columns());
+    }
+    for (unsigned i = 0; i < _partitions.size(); i++) {
+        ExchangePartition* partition = new ExchangePartition(this, i, input->n_columns(), rescannable);
+        _partition_inputs.emplace_back(partition);
+        add_pipeline(pipeline == NULL ? partition : pipeline(partition));
+    }
 }
 
-NestedLoopsJoin::~NestedLoopsJoin()
+Exchange::~Exchange()
 {
-    delete _left;
-    delete _right;
+    Exchange::close();
+    delete _input;
 }
 
 //----------------------------------------------------------------------
 
-// Sort
+// ExchangePartition
 
-unsigned Sort::n_columns() 
+unsigned ExchangePartition::n_columns()
 {
-    return _input->n_columns();
+    return _n_columns;
 }
 
-void Sort::open() 
+void ExchangePartition::open()
 {
-    _input->open();
-    Row *row;
-    while ((row = _input->next()) != NULL) {
-        _sorted.emplace_back(row);
+    // Unless rescans were requested, rows are passed on as received, so the partition can be read only once.
+    assert(_rescannable || !_opened);
+    _opened = true;
+    _position = 0;
+}
+
+Row* ExchangePartition::next()
+{
+    if (_position == _received.size() && !receive()) {
+        return NULL;
     }
-    std::sort(_sorted.begin(), _sorted.end(), RowCompare(_sort_columns));
-    _sorted_iterator = _sorted.begin();
+    return output(_received[_position++]);
 }
 
-Row* Sort::next() 
+unsigned ExchangePartition::next_batch(RowBatch& batch)
 {
-    Row* next = NULL;
-    if (_sorted_iterator != _sorted.end()) {
-        next = *(_sorted_iterator++);
+    batch.clear();
+    while (!batch.full() && (_position < _received.size() || receive())) {
+        batch.emplace_back(output(_received[_position++]));
     }
-    return next;
+    return (unsigned) batch.size();
 }
 
-void Sort::close() 
+void ExchangePartition::close()
 {
-    _input->close();
-    _sorted.clear();
+    if (_rescannable) {
+        _position = _received.size();
+    } else {
+        discard();
+    }
 }
 
-Sort::Sort(Iterator* input, const initializer_list<unsigned>& sort_columns)
-    : _input(input),
-      _sort_columns(sort_columns)
-{}
+void ExchangePartition::restart()
+{
+    discard();
+    _opened = false;
+}
 
-Sort::~Sort()
+// Reclaim the rows received, except those passed on without being kept
+void ExchangePartition::discard()
 {
-    delete _input;
+    for (unsigned long i = _rescannable ? 0 : _position; i < _received.size(); i++) {
+        Row::reclaim(_received[i]);
+    }
+    _received.clear();
+    _position = 0;
+}
+
+// Receive more rows from the Exchange, returning false if there are no more
+bool ExchangePartition::receive()
+{
+    if (_exchange->receive(_partition, _batch) == 0) {
+        return false;
+    }
+    if (!_rescannable) {
+        // The rows received earlier have all been passed on.
+        _received.clear();
+        _position = 0;
+    }
+    _received.insert(_received.end(), _batch.begin(), _batch.end());
+    return true;
+}
+
+// If the received rows are kept, intermediate rows are output as copies, which the consumer may reclaim.
+Row* ExchangePartition::output(Row* row)
+{
+    if (!_rescannable || !row->is_intermediate_row()) {
+        return row;
+    }
+    Row* copy = Row::make_intermediate();
+    *copy = *row;
+    return copy;
 }
 
+ExchangePartition::ExchangePartition(Exchange* exchange, unsigned partition, unsigned n_columns, bool rescannable)
+    : _exchange(exchange),
+      _partition(partition),
+      _n_columns(n_columns),
+      _rescannable(rescannable),
+      _opened(false),
+      _position(0)
+{}
+
 //----------------------------------------------------------------------
 
-// Unique
+// IndexScan
 
-unsigned Unique::n_columns()
+unsigned IndexScan::n_columns()
 {
-    return _input->n_columns();
+    return _index->n_columns();
 }
 
-void Unique::open() 
+void IndexScan::open()
 {
-    _input->open();
-    _next_unique = new Row();
+    _input = _index->lower_bound(_index->key(*_lo));
+    _end = _index->upper_bound(_index->key(*_hi));
 }
 
-Row* Unique::next()
+
+Row* IndexScan::next()
 {
     Row* next = NULL;
-    while ((next = _input->next()) != NULL) {
-        if ((*next) != (*_next_unique)) {
-            *_next_unique = *next;
-            break;
-        } else {
-            Row::reclaim(next);
-        }
+    if (_input != _end) {
+        next = (_input++)->second;
     }
     return next;
 }
 
-void Unique::close() 
+unsigned IndexScan::next_batch(RowBatch& batch)
 {
-    _input->close();
-    delete _next_unique;
+    batch.clear();
+    while (_input != _end && !batch.full()) {
+        batch.emplace_back((_input++)->second);
+    }
+    return (unsigned) batch.size();
 }
 
-Unique::Unique(Iterator* input)
-    : _input(input),
-      _next_unique(NULL)
-{}
-
-Unique::~Unique()
+void IndexScan::close()
 {
-    delete _input;
+    _input = _end;
 }
+
+IndexScan::IndexScan(Index* index, Row* lo, Row* hi)
+    : _index(index),
+      _lo(lo),
+      _hi(hi == NULL ? lo : hi)
+{}
+
+//----------------------------------------------------------------------
+
+// HashIndexScan
+
+unsigned HashIndexScan::n_columns()
+{
+    return _index->n_columns();
+}
+
+void HashIndexScan::open()
+{
+    auto range = _index->equal_range(_index->key(*_key));
+    _input = range.first;
+    _end = range.second;
+}
+
+Row* HashIndexScan::next()
+{
+    Row* next = NULL;
+    if (_input != _end) {
+        next = (_input++)->second;
+    }
+    return next;
+}
+
+unsigned HashIndexScan::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    while (_input != _end && !batch.full()) {
+        batch.emplace_back((_input++)->second);
+    }
+    return (unsigned) batch.size();
+}
+
+void HashIndexScan::close()
+{
+    _input = _end;
+}
+
+HashIndexScan::HashIndexScan(HashIndex* index, Row* key)
+    : _index(index),
+      _key(key)
+{}
+
+//----------------------------------------------------------------------
+
+// Select
+
+unsigned Select::n_columns()
+{
+    return _input->n_columns();
+}
+
+void Select::open()
+{
+    // If _value isn't in the dictionary, then it matches no code.
+    _value_code = _predicate == NULL ? Database::dictionary()->code(_value) : Dictionary::NO_CODE;
+    _input->open();
+}
+
+Row* Select::next()
+{
+    Row* next = _input->next();
+    while (next != NULL && !selected(next)) {
+        Row::reclaim(next);
+        next = _input->next();
+    }
+    return next;
+}
+
+unsigned Select::next_batch(RowBatch& batch)
+{
+    // Filter each input batch in place, until some row survives or the input is exhausted.
+    while (_input->next_batch(batch) > 0) {
+        unsigned long n = 0;
+        for (Row* row : batch) {
+            if (selected(row)) {
+                batch[n++] = row;
+            } else {
+                Row::reclaim(row);
+            }
+        }
+        batch.resize(n);
+        if (n > 0) {
+            break;
+        }
+    }
+    return (unsigned) batch.size();
+}
+
+void Select::close()
+{
+    _input->close();
+}
+
+bool Select::selected(const Row* row)
+{
+    if (_predicate != NULL) {
+        return _predicate(row);
+    }
+    unsigned code = row->code(_column);
+    return code == Dictionary::NO_CODE ? row->at(_column) == _value : code == _value_code;
+}
+
+Select::Select(Iterator* input, RowPredicate predicate)
+    : _input(input),
+      _predicate(predicate),
+      _column(0),
+      _value_code(Dictionary::NO_CODE)
+{
+}
+
+Select::Select(Iterator* input, unsigned column, const string& value)
+    : _input(input),
+      _predicate(NULL),
+      _column(column),
+      _value(value),
+      _value_code(Dictionary::NO_CODE)
+{
+    assert(column < input->n_columns());
+}
+
+Select::~Select()
+{
+    delete _input;
+}
+
+//----------------------------------------------------------------------
+
+// Project
+
+unsigned Project::n_columns()
+{
+    return _column_selector.n_selected();
+}
+
+void Project::open()
+{
+    _input->open();
+}
+
+Row* Project::next()
+{
+    const RowView* view = Project::next_view();
+    return view == NULL ? NULL : view->materialize();
+}
+
+unsigned Project::next_batch(RowBatch& batch)
+{
+    // Only the projected values are copied out of the input's views.
+    batch.clear();
+    const RowView* view;
+    while (!batch.full() && (view = Project::next_view()) != NULL) {
+        batch.emplace_back(view->materialize());
+    }
+    return (unsigned) batch.size();
+}
+
+const RowView* Project::next_view()
+{
+    const RowView* row = _input->next_view();
+    if (row == NULL) {
+        return NULL;
+    }
+    _view.clear();
+    for (unsigned i = 0; i < _column_selector.n_selected(); i++) {
+        _view.append(row, _column_selector.selected(i));
+    }
+    return &_view;
+}
+
+void Project::close()
+{
+    _input->close();
+}
+
+Project::Project(Iterator* input, const initializer_list<unsigned>& columns)
+    : _input(input),
+      _column_selector(input->n_columns(), columns)
+{}
+
+Project::~Project()
+{
+    delete _input;
+}
+
+//----------------------------------------------------------------------
+
+// Join
+
+unsigned Join::n_columns()
+{
+    return _left_join_columns.n_columns() + _right_join_columns.n_unselected();
+}
+
+Row* Join::next()
+{
+    const RowView* view = next_view();
+    return view == NULL ? NULL : view->materialize();
+}
+
+unsigned Join::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    const RowView* view;
+    while (!batch.full() && (view = next_view()) != NULL) {
+        batch.emplace_back(view->materialize());
+    }
+    return (unsigned) batch.size();
+}
+
+const RowView* Join::join_views(const Row* left, const Row* right)
+{
+    _view.clear();
+    unsigned lcols = _left_join_columns.n_columns();
+    unsigned rcols = _right_join_columns.n_unselected();
+    for (unsigned i = 0; i < lcols; i++) {
+        _view.append(left, i);
+    }
+    for (unsigned i = 0; i < rcols; i++) {
+        _view.append(right, _right_join_columns.unselected(i));
+    }
+    return &_view;
+}
+
+const RowView* Join::join_views(const RowView* left, const RowView* right)
+{
+    _view.clear();
+    unsigned lcols = _left_join_columns.n_columns();
+    unsigned rcols = _right_join_columns.n_unselected();
+    for (unsigned i = 0; i < lcols; i++) {
+        _view.append(left, i);
+    }
+    for (unsigned i = 0; i < rcols; i++) {
+        _view.append(right, _right_join_columns.unselected(i));
+    }
+    return &_view;
+}
+
+bool Join::match(const Row* left, const Row* right)
+{
+    unsigned cols = _left_join_columns.n_selected();
+    for (unsigned i = 0; i < cols; i++) {
+        if (!left->equal(_left_join_columns.selected(i), right, _right_join_columns.selected(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Join::match(const RowView* left, const RowView* right)
+{
+    unsigned cols = _left_join_columns.n_selected();
+    for (unsigned i = 0; i < cols; i++) {
+        if (!left->equal(_left_join_columns.selected(i), right, _right_join_columns.selected(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Row Join::left_key(const Row* left)
+{
+    Row key;
+    unsigned cols = _left_join_columns.n_selected();
+    key.reserve(cols);
+    for (unsigned i = 0; i < cols; i++) {
+        key.append(left, _left_join_columns.selected(i));
+    }
+    return key;
+}
+
+Row Join::right_key(const Row* right)
+{
+    Row key;
+    unsigned cols = _right_join_columns.n_selected();
+    key.reserve(cols);
+    for (unsigned i = 0; i < cols; i++) {
+        key.append(right, _right_join_columns.selected(i));
+    }
+    return key;
+}
+
+Join::Join(unsigned n_left_columns,
+           const vector<unsigned>& left_join_columns,
+           unsigned n_right_columns,
+           const vector<unsigned>& right_join_columns)
+    : _left_join_columns(n_left_columns, left_join_columns),
+      _right_join_columns(n_right_columns, right_join_columns)
+{
+    assert(_left_join_columns.n_selected() == _right_join_columns.n_selected());
+}
+
+//----------------------------------------------------------------------
+
+// NestedLoopsJoin
+
+void NestedLoopsJoin::open()
+{
+    _left->open();
+    _right->open();
+    _right_view = _right->next_view();
+}
+
+const RowView* NestedLoopsJoin::next_view()
+{
+    // For each right row, scan the left input from the beginning, returning each matching left row. Inputs are
+    // read as views, so the joined values are not copied.
+    const RowView* next = NULL;
+    while (next == NULL && _right_view != NULL) {
+        const RowView* left_view = _left->next_view();
+        if (left_view == NULL) {
+            _right_view = _right->next_view();
+            if (_right_view != NULL) {
+                _left->close();
+                _left->open();
+            }
+        } else if (match(left_view, _right_view)) {
+            next = join_views(left_view, _right_view);
+        }
+    }
+    return next;
+}
+
+void NestedLoopsJoin::close()
+{
+    _left->close();
+    _right->close();
+    _right_view = NULL;
+}
+
+NestedLoopsJoin::NestedLoopsJoin(Iterator* left,
+                                 const initializer_list<unsigned>& left_join_columns,
+                                 Iterator* right,
+                                 const initializer_list<unsigned>& right_join_columns)
+    : Join(left->n_columns(), left_join_columns, right->n_columns(), right_join_columns),
+      _left(left),
+      _right(right),
+      _right_view(NULL)
+{}
+
+NestedLoopsJoin::~NestedLoopsJoin()
+{
+    delete _left;
+    delete _right;
+}
+
+//----------------------------------------------------------------------
+
+// BlockNestedLoopsJoin
+
+void BlockNestedLoopsJoin::open()
+{
+    _left->open();
+    _right->open();
+    _right_row = NULL;
+    _block_position = 0;
+    next_block();
+}
+
+const RowView* BlockNestedLoopsJoin::next_view()
+{
+    // Each right row is compared with every left row in the current block. The right input is rescanned once
+    // per block, and the left input is scanned just once.
+    const RowView* next = NULL;
+    while (next == NULL && !_block.empty()) {
+        if (_right_row != NULL && _block_position < _block.size()) {
+            Row* left_row = _block.at(_block_position++);
+            if (match(left_row, _right_row)) {
+                next = join_views(left_row, _right_row);
+            }
+        } else {
+            Row::reclaim(_right_row);
+            _right_row = _right->next();
+            _block_position = 0;
+            if (_right_row == NULL) {
+                next_block();
+                if (!_block.empty()) {
+                    _right->close();
+                    _right->open();
+                }
+            }
+        }
+    }
+    return next;
+}
+
+void BlockNestedLoopsJoin::next_block()
+{
+    for (Row* left_row : _block) {
+        Row::reclaim(left_row);
+    }
+    _block.clear();
+    while (_block.size() < _block_size) {
+        _left_batch.set_size_limit(min(_block_size - (unsigned) _block.size(), RowBatch::DEFAULT_SIZE_LIMIT));
+        if (_left->next_batch(_left_batch) == 0) {
+            break;
+        }
+        _block.insert(_block.end(), _left_batch.begin(), _left_batch.end());
+    }
+    _left_batch.clear();
+}
+
+void BlockNestedLoopsJoin::close()
+{
+    _left->close();
+    _right->close();
+    for (Row* left_row : _block) {
+        Row::reclaim(left_row);
+    }
+    _block.clear();
+    Row::reclaim(_right_row);
+    _right_row = NULL;
+}
+
+BlockNestedLoopsJoin::BlockNestedLoopsJoin(Iterator* left,
+                                           const initializer_list<unsigned>& left_join_columns,
+                                           Iterator* right,
+                                           const initializer_list<unsigned>& right_join_columns,
+                                           unsigned block_size)
+    : Join(left->n_columns(), left_join_columns, right->n_columns(), right_join_columns),
+      _left(left),
+      _right(right),
+      _block_size(block_size),
+      _block_position(0),
+      _right_row(NULL)
+{
+    assert(_block_size > 0);
+}
+
+BlockNestedLoopsJoin::~BlockNestedLoopsJoin()
+{
+    delete _left;
+    delete _right;
+}
+
+//----------------------------------------------------------------------
+
+// HashJoin
+
+void HashJoin::open()
+{
+    _left->open();
+    RowBatch batch;
+    while (_left->next_batch(batch) > 0) {
+        for (Row* left_row : batch) {
+            _left_rows[HashIndexKeyHash()(left_key(left_row))].emplace_back(left_row);
+        }
+    }
+    _right->open();
+    _right_batch.clear();
+    _right_position = 0;
+    _right_row = NULL;
+    _matches = NULL;
+    _match_position = 0;
+}
+
+const RowView* HashJoin::next_view()
+{
+    // Each right row is joined with its matching left rows in left input order, so the output is in the same
+    // order as that of NestedLoopsJoin.
+    const RowView* next = NULL;
+    while (next == NULL) {
+        if (_matches != NULL && _match_position < _matches->size()) {
+            Row* left_row = _matches->at(_match_position++);
+            if (match(left_row, _right_row)) {
+                next = join_views(left_row, _right_row);
+            }
+        } else {
+            Row::reclaim(_right_row);
+            _right_row = NULL;
+            _matches = NULL;
+            if (_right_position == _right_batch.size()) {
+                _right_position = 0;
+                if (_right->next_batch(_right_batch) == 0) {
+                    break;
+                }
+            }
+            _right_row = _right_batch.at(_right_position++);
+            auto matches = _left_rows.find(HashIndexKeyHash()(right_key(_right_row)));
+            if (matches != _left_rows.end()) {
+                _matches = &matches->second;
+                _match_position = 0;
+            }
+        }
+    }
+    return next;
+}
+
+void HashJoin::close()
+{
+    _left->close();
+    _right->close();
+    Row::reclaim(_right_row);
+    _right_row = NULL;
+    while (_right_position < _right_batch.size()) {
+        Row::reclaim(_right_batch.at(_right_position++));
+    }
+    _right_batch.clear();
+    _matches = NULL;
+    for (auto& entry : _left_rows) {
+        for (Row* left_row : entry.second) {
+            Row::reclaim(left_row);
+        }
+    }
+    _left_rows.clear();
+}
+
+HashJoin::HashJoin(Iterator* left,
+                   const initializer_list<unsigned>& left_join_columns,
+                   Iterator* right,
+                   const initializer_list<unsigned>& right_join_columns)
+    : Join(left->n_columns(), left_join_columns, right->n_columns(), right_join_columns),
+      _left(left),
+      _right(right),
+      _right_position(0),
+      _right_row(NULL),
+      _matches(NULL),
+      _match_position(0)
+{}
+
+HashJoin::~HashJoin()
+{
+    delete _left;
+    delete _right;
+}
+
+//----------------------------------------------------------------------
+
+// MergeJoin
+
+void MergeJoin::open()
+{
+    _left->open();
+    _right->open();
+    _left_row = _left->next();
+    _right_row = NULL;
+    _run_position = 0;
+}
+
+const RowView* MergeJoin::next_view()
+{
+    // Both inputs are sorted on their join columns. Each right row is joined with the run of left rows having
+    // the same key. Consecutive right rows with the same key reuse the run, which handles many-to-many joins.
+    const RowView* next = NULL;
+    while (next == NULL) {
+        if (_right_row != NULL && _run_position < _left_run.size()) {
+            next = join_views(_left_run.at(_run_position++), _right_row);
+        } else {
+            Row::reclaim(_right_row);
+            _right_row = _right->next();
+            if (_right_row == NULL) {
+                break;
+            }
+            _run_position = 0;
+            if (_left_run.empty() || _key_compare.compare(_left_run.front(), _right_row) != 0) {
+                start_run();
+            }
+        }
+    }
+    return next;
+}
+
+void MergeJoin::start_run()
+{
+    for (Row* left_row : _left_run) {
+        Row::reclaim(left_row);
+    }
+    _left_run.clear();
+    while (_left_row != NULL && _key_compare.compare(_left_row, _right_row) < 0) {
+        Row::reclaim(_left_row);
+        _left_row = _left->next();
+    }
+    while (_left_row != NULL && _key_compare.compare(_left_row, _right_row) == 0) {
+        _left_run.emplace_back(_left_row);
+        _left_row = _left->next();
+    }
+}
+
+void MergeJoin::close()
+{
+    _left->close();
+    _right->close();
+    for (Row* left_row : _left_run) {
+        Row::reclaim(left_row);
+    }
+    _left_run.clear();
+    Row::reclaim(_left_row);
+    _left_row = NULL;
+    Row::reclaim(_right_row);
+    _right_row = NULL;
+}
+
+MergeJoin::MergeJoin(Iterator* left,
+                     const initializer_list<unsigned>& left_join_columns,
+                     Iterator* right,
+                     const initializer_list<unsigned>& right_join_columns)
+    : Join(left->n_columns(), left_join_columns, right->n_columns(), right_join_columns),
+      _left(left),
+      _right(right),
+      _key_compare(left_join_columns, right_join_columns),
+      _run_position(0),
+      _left_row(NULL),
+      _right_row(NULL)
+{}
+
+MergeJoin::~MergeJoin()
+{
+    delete _left;
+    delete _right;
+}
+
+//----------------------------------------------------------------------
+
+// IndexJoin
+
+void IndexJoin::open()
+{
+    _outer->open();
+    _outer_row = NULL;
+}
+
+const RowView* IndexJoin::next_view()
+{
+    // Each outer row is joined with the indexed rows found by looking up the outer row's join columns.
+    const RowView* next = NULL;
+    while (next == NULL) {
+        if (_outer_row != NULL && _input != _end) {
+            next = join_views(_outer_row, (_input++)->second);
+        } else {
+            Row::reclaim(_outer_row);
+            _outer_row = _outer->next();
+            if (_outer_row == NULL) {
+                break;
+            }
+            Row key = _index->key(left_key(_outer_row));
+            _input = _index->lower_bound(key);
+            _end = _index->upper_bound(key);
+        }
+    }
+    return next;
+}
+
+void IndexJoin::close()
+{
+    _outer->close();
+    Row::reclaim(_outer_row);
+    _outer_row = NULL;
+}
+
+IndexJoin::IndexJoin(Iterator* outer,
+                     const initializer_list<unsigned>& outer_join_columns,
+                     Index* index)
+    : Join(outer->n_columns(), outer_join_columns, index->n_columns(), index->key_columns()),
+      _outer(outer),
+      _index(index),
+      _outer_row(NULL)
+{}
+
+IndexJoin::~IndexJoin()
+{
+    delete _outer;
+}
+
+//----------------------------------------------------------------------
+
+// Sort
+
+unsigned Sort::n_columns() 
+{
+    return _input->n_columns();
+}
+
+void Sort::open() 
+{
+    _input->open();
+    _sorted_size = 0;
+    RowBatch batch;
+    while (_input->next_batch(batch) > 0) {
+        for (Row* row : batch) {
+            _sorted.emplace_back(row);
+            _sorted_size += row_size(row);
+        }
+        if (_memory_budget > 0 && _sorted_size > _memory_budget) {
+            spill();
+        }
+    }
+    if (_runs.empty()) {
+        sort_rows();
+        _sorted_iterator = _sorted.begin();
+    } else {
+        spill();
+        _run_heads.resize(_runs.size());
+        for (unsigned run = 0; run < _runs.size(); run++) {
+            _runs[run]->rewind();
+            _run_heads[run] = _runs[run]->read();
+            merge_push(run);
+        }
+        _sorted_iterator = _sorted.end();
+    }
+}
+
+Row* Sort::next() 
+{
+    Row* next = NULL;
+    if (_sorted_iterator != _sorted.end()) {
+        next = *(_sorted_iterator++);
+    } else if (!_merge_heap.empty()) {
+        RowCompare compare(_sort_columns);
+        pop_heap(_merge_heap.begin(), _merge_heap.end(),
+                 [&](unsigned x, unsigned y) { return compare.compare(_run_heads[x], _run_heads[y]) > 0; });
+        unsigned run = _merge_heap.back();
+        _merge_heap.pop_back();
+        next = _run_heads[run];
+        _run_heads[run] = _runs[run]->read();
+        merge_push(run);
+    }
+    return next;
+}
+
+unsigned Sort::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    Row* row;
+    while (!batch.full() && (row = Sort::next()) != NULL) {
+        batch.emplace_back(row);
+    }
+    return (unsigned) batch.size();
+}
+
+void Sort::close() 
+{
+    _input->close();
+    _sorted.clear();
+    for (Row* head : _run_heads) {
+        if (head) {
+            Row::reclaim(head);
+        }
+    }
+    _run_heads.clear();
+    _merge_heap.clear();
+    for (SortRun* run : _runs) {
+        delete run;
+    }
+    _runs.clear();
+}
+
+Sort::Sort(Iterator* input,
+           const initializer_list<unsigned>& sort_columns,
+           unsigned n_threads,
+           unsigned long memory_budget)
+    : _input(input),
+      _sort_columns(sort_columns),
+      _n_threads(n_threads),
+      _memory_budget(memory_budget),
+      _sorted_size(0)
+{}
+
+Sort::~Sort()
+{
+    delete _input;
+}
+
+void Sort::sort_rows()
+{
+    if (_n_threads > 1) {
+        parallel_stable_sort(_sorted.begin(), _sorted.end(), RowCompare(_sort_columns), _n_threads);
+    } else {
+        std::sort(_sorted.begin(), _sorted.end(), RowCompare(_sort_columns));
+    }
+}
+
+// Sort the rows collected so far, and write them to a new run, freeing their memory
+void Sort::spill()
+{
+    sort_rows();
+    SortRun* run = new SortRun();
+    _runs.emplace_back(run);
+    for (Row* row : _sorted) {
+        run->write(row);
+        Row::reclaim(row);
+    }
+    _sorted.clear();
+    _sorted_size = 0;
+}
+
+// Add run to the merge heap, unless it is exhausted. The heap is ordered so that the run with the smallest head is
+// at the front.
+void Sort::merge_push(unsigned run)
+{
+    if (_run_heads[run]) {
+        RowCompare compare(_sort_columns);
+        _merge_heap.emplace_back(run);
+        push_heap(_merge_heap.begin(), _merge_heap.end(),
+                  [&](unsigned x, unsigned y) { return compare.compare(_run_heads[x], _run_heads[y]) > 0; });
+    }
+}
+
+// An estimate of the memory used by row
+unsigned long Sort::row_size(const Row* row)
+{
+    unsigned long size = sizeof(Row) + row->size() * (sizeof(string) + sizeof(unsigned) + sizeof(long));
+    for (const string& value : *row) {
+        size += value.size();
+    }
+    return size;
+}
+
+//----------------------------------------------------------------------
+
+// TopN
+
+unsigned TopN::n_columns()
+{
+    return _input->n_columns();
+}
+
+void TopN::open()
+{
+    _input->open();
+    // _top is a max-heap, so the row to be displaced by a smaller one is at the front.
+    RowCompare less(_sort_columns);
+    RowBatch batch;
+    while (_input->next_batch(batch) > 0) {
+        for (Row* row : batch) {
+            if (_top.size() < _n) {
+                _top.emplace_back(row);
+                push_heap(_top.begin(), _top.end(), less);
+            } else if (_n > 0 && less.compare(row, _top.front()) < 0) {
+                pop_heap(_top.begin(), _top.end(), less);
+                Row::reclaim(_top.back());
+                _top.back() = row;
+                push_heap(_top.begin(), _top.end(), less);
+            } else {
+                Row::reclaim(row);
+            }
+        }
+    }
+    sort_heap(_top.begin(), _top.end(), less);
+    _top_iterator = _top.begin();
+}
+
+Row* TopN::next()
+{
+    Row* next = NULL;
+    if (_top_iterator != _top.end()) {
+        next = *(_top_iterator++);
+    }
+    return next;
+}
+
+unsigned TopN::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    while (_top_iterator != _top.end() && !batch.full()) {
+        batch.emplace_back(*(_top_iterator++));
+    }
+    return (unsigned) batch.size();
+}
+
+void TopN::close()
+{
+    _input->close();
+    while (_top_iterator != _top.end()) {
+        Row::reclaim(*(_top_iterator++));
+    }
+    _top.clear();
+}
+
+TopN::TopN(Iterator* input, const initializer_list<unsigned>& sort_columns, unsigned n)
+    : _input(input),
+      _sort_columns(sort_columns),
+      _n(n)
+{}
+
+TopN::~TopN()
+{
+    delete _input;
+}
+
+//----------------------------------------------------------------------
+
+// Limit
+
+unsigned Limit::n_columns()
+{
+    return _input->n_columns();
+}
+
+void Limit::open()
+{
+    _input->open();
+    _produced = 0;
+}
+
+Row* Limit::next()
+{
+    Row* next = NULL;
+    if (_produced < _n && (next = _input->next()) != NULL) {
+        _produced++;
+    }
+    return next;
+}
+
+unsigned Limit::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    if (_produced < _n) {
+        // Ask the input for no more rows than are still needed, and discard any extras.
+        unsigned size_limit = batch.size_limit();
+        batch.set_size_limit(min(size_limit, _n - _produced));
+        _input->next_batch(batch);
+        batch.set_size_limit(size_limit);
+        while (batch.size() > _n - _produced) {
+            Row::reclaim(batch.back());
+            batch.pop_back();
+        }
+        _produced += (unsigned) batch.size();
+    }
+    return (unsigned) batch.size();
+}
+
+const RowView* Limit::next_view()
+{
+    const RowView* next = NULL;
+    if (_produced < _n && (next = _input->next_view()) != NULL) {
+        _produced++;
+    }
+    return next;
+}
+
+void Limit::close()
+{
+    _input->close();
+}
+
+Limit::Limit(Iterator* input, unsigned n)
+    : _input(input),
+      _n(n),
+      _produced(0)
+{}
+
+Limit::~Limit()
+{
+    delete _input;
+}
+
+//----------------------------------------------------------------------
+
+// Unique
+
+unsigned Unique::n_columns()
+{
+    return _input->n_columns();
+}
+
+void Unique::open() 
+{
+    _input->open();
+    _next_unique = new Row();
+}
+
+Row* Unique::next()
+{
+    Row* next = NULL;
+    while ((next = _input->next()) != NULL) {
+        if (!next->equal(_next_unique)) {
+            *_next_unique = *next;
+            break;
+        } else {
+            Row::reclaim(next);
+        }
+    }
+    return next;
+}
+
+unsigned Unique::next_batch(RowBatch& batch)
+{
+    // Filter each input batch in place, until some row survives or the input is exhausted.
+    while (_input->next_batch(batch) > 0) {
+        unsigned long n = 0;
+        for (Row* row : batch) {
+            if (!row->equal(_next_unique)) {
+                *_next_unique = *row;
+                batch[n++] = row;
+            } else {
+                Row::reclaim(row);
+            }
+        }
+        batch.resize(n);
+        if (n > 0) {
+            break;
+        }
+    }
+    return (unsigned) batch.size();
+}
+
+void Unique::close() 
+{
+    _input->close();
+    delete _next_unique;
+}
+
+Unique::Unique(Iterator* input)
+    : _input(input),
+      _next_unique(NULL)
+{}
+
+Unique::~Unique()
+{
+    delete _input;
+}
+
+//----------------------------------------------------------------------
+
+// HashDistinct
+
+unsigned HashDistinct::n_columns()
+{
+    return _input->n_columns();
+}
+
+void HashDistinct::open()
+{
+    _input->open();
+}
+
+Row* HashDistinct::next()
+{
+    Row* next = _input->next();
+    while (next != NULL && !first(next)) {
+        Row::reclaim(next);
+        next = _input->next();
+    }
+    return next;
+}
+
+unsigned HashDistinct::next_batch(RowBatch& batch)
+{
+    // Filter each input batch in place, until some row survives or the input is exhausted.
+    while (_input->next_batch(batch) > 0) {
+        unsigned long n = 0;
+        for (Row* row : batch) {
+            if (first(row)) {
+                batch[n++] = row;
+            } else {
+                Row::reclaim(row);
+            }
+        }
+        batch.resize(n);
+        if (n > 0) {
+            break;
+        }
+    }
+    return (unsigned) batch.size();
+}
+
+void HashDistinct::close()
+{
+    _input->close();
+    _seen.clear();
+}
+
+// Whether row is the first of its value to be seen. Only rows that are, are copied.
+bool HashDistinct::first(const Row* row)
+{
+    if (_seen.find(*row) != _seen.end()) {
+        return false;
+    }
+    _seen.emplace(*row);
+    return true;
+}
+
+HashDistinct::HashDistinct(Iterator* input)
+    : _input(input)
+{}
+
+HashDistinct::~HashDistinct()
+{
+    delete _input;
+}
+
+//----------------------------------------------------------------------
+
+// Aggregation
+
+unsigned Aggregation::n_columns()
+{
+    return (unsigned) (_group_columns.size() + _aggregates.size());
+}
+
+Row* Aggregation::new_group(const Row* row)
+{
+    Row* group = Row::make_intermediate();
+    for (unsigned column : _group_columns) {
+        group->append(row, column);
+    }
+    for (const Aggregate& aggregate : _aggregates) {
+        if (aggregate.function == COUNT_AGGREGATE || aggregate.function == SUM_AGGREGATE) {
+            group->append("", Dictionary::NO_CODE, 0);
+        } else {
+            group->append(row, aggregate.column);
+        }
+    }
+    return group;
+}
+
+void Aggregation::accumulate(Row* group, const Row* row)
+{
+    unsigned first_aggregate = (unsigned) _group_columns.size();
+    for (unsigned a = 0; a < _aggregates.size(); a++) {
+        const Aggregate& aggregate = _aggregates[a];
+        unsigned column = first_aggregate + a;
+        if (aggregate.function == COUNT_AGGREGATE) {
+            group->set_native(column, group->native(column) + 1);
+        } else if (aggregate.function == SUM_AGGREGATE) {
+            long value = row->native(aggregate.column);
+            if (value == NO_NATIVE) {
+                value = native_value(INTEGER_COLUMN, row->at(aggregate.column));
+            }
+            group->set_native(column, group->native(column) + value);
+        } else {
+            int comparison = row->compare(aggregate.column, group, column);
+            if (aggregate.function == MIN_AGGREGATE ? comparison < 0 : comparison > 0) {
+                (*group)[column] = row->at(aggregate.column);
+                group->set_code(column, row->code(aggregate.column));
+                group->set_native(column, row->native(aggregate.column));
+            }
+        }
+    }
+}
+
+void Aggregation::finish(Row* group)
+{
+    unsigned first_aggregate = (unsigned) _group_columns.size();
+    for (unsigned a = 0; a < _aggregates.size(); a++) {
+        AggregateFunction function = _aggregates[a].function;
+        if (function == COUNT_AGGREGATE || function == SUM_AGGREGATE) {
+            unsigned column = first_aggregate + a;
+            (*group)[column] = to_string(group->native(column));
+        }
+    }
+}
+
+bool Aggregation::in_group(const Row* group, const Row* row)
+{
+    for (unsigned i = 0; i < _group_columns.size(); i++) {
+        if (!group->equal(i, row, _group_columns[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Aggregation::Aggregation(Iterator* input,
+                         const initializer_list<unsigned>& group_columns,
+                         const initializer_list<Aggregate>& aggregates)
+    : _input(input),
+      _group_columns(group_columns),
+      _aggregates(aggregates)
+{
+    for (const Aggregate& aggregate : _aggregates) {
+        assert(aggregate.function == COUNT_AGGREGATE || aggregate.column < input->n_columns());
+    }
+}
+
+Aggregation::~Aggregation()
+{
+    delete _input;
+}
+
+//----------------------------------------------------------------------
+
+// HashAggregate
+
+void HashAggregate::open()
+{
+    _input->open();
+    _groups_iterator = _groups.end();
+    RowBatch batch;
+    unsigned long position = 0;
+    try {
+        while (_input->next_batch(batch) > 0) {
+            for (position = 0; position < batch.size(); position++) {
+                accumulate(group(batch[position]), batch[position]);
+                Row::reclaim(batch[position]);
+            }
+        }
+    } catch (TableException& e) {
+        // Leave no partial groups, so that close() can follow.
+        for (; position < batch.size(); position++) {
+            Row::reclaim(batch[position]);
+        }
+        for (Row* group : _groups) {
+            Row::reclaim(group);
+        }
+        _groups.clear();
+        _groups_by_key.clear();
+        _groups_iterator = _groups.end();
+        throw;
+    }
+    _groups_by_key.clear();
+    for (Row* group : _groups) {
+        finish(group);
+    }
+    _groups_iterator = _groups.begin();
+}
+
+Row* HashAggregate::next()
+{
+    Row* next = NULL;
+    if (_groups_iterator != _groups.end()) {
+        next = *(_groups_iterator++);
+    }
+    return next;
+}
+
+unsigned HashAggregate::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    while (_groups_iterator != _groups.end() && !batch.full()) {
+        batch.emplace_back(*(_groups_iterator++));
+    }
+    return (unsigned) batch.size();
+}
+
+void HashAggregate::close()
+{
+    _input->close();
+    while (_groups_iterator != _groups.end()) {
+        Row::reclaim(*(_groups_iterator++));
+    }
+    _groups.clear();
+}
+
+// The output row for the group of the given input row, created if this is the first row of the group
+Row* HashAggregate::group(const Row* row)
+{
+    Row key;
+    key.reserve(_group_columns.size());
+    for (unsigned column : _group_columns) {
+        key.append(row, column);
+    }
+    auto found = _groups_by_key.find(key);
+    if (found != _groups_by_key.end()) {
+        return found->second;
+    }
+    Row* group = new_group(row);
+    _groups.emplace_back(group);
+    _groups_by_key.emplace(move(key), group);
+    return group;
+}
+
+HashAggregate::HashAggregate(Iterator* input,
+                             const initializer_list<unsigned>& group_columns,
+                             const initializer_list<Aggregate>& aggregates)
+    : Aggregation(input, group_columns, aggregates)
+{}
+
+//----------------------------------------------------------------------
+
+// SortedAggregate
+
+void SortedAggregate::open()
+{
+    _input->open();
+    _next_row = _input->next();
+}
+
+Row* SortedAggregate::next()
+{
+    if (_next_row == NULL) {
+        return NULL;
+    }
+    Row* group = new_group(_next_row);
+    try {
+        do {
+            accumulate(group, _next_row);
+            Row::reclaim(_next_row);
+            _next_row = _input->next();
+        } while (_next_row != NULL && in_group(group, _next_row));
+    } catch (TableException& e) {
+        Row::reclaim(group);
+        throw;
+    }
+    finish(group);
+    return group;
+}
+
+unsigned SortedAggregate::next_batch(RowBatch& batch)
+{
+    batch.clear();
+    Row* row;
+    while (!batch.full() && (row = SortedAggregate::next()) != NULL) {
+        batch.emplace_back(row);
+    }
+    return (unsigned) batch.size();
+}
+
+void SortedAggregate::close()
+{
+    Row::reclaim(_next_row);
+    _next_row = NULL;
+    _input->close();
+}
+
+SortedAggregate::SortedAggregate(Iterator* input,
+                                 const initializer_list<unsigned>& group_columns,
+                                 const initializer_list<Aggregate>& aggregates)
+    : Aggregation(input, group_columns, aggregates),
+      _next_row(NULL)
+{}
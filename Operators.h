@@ -1,18 +1,32 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "Aggregate.h"
 #include "Iterator.h"
 #include "Index.h"
+#include "HashIndex.h"
 #include "Row.h"
 #include "ColumnSelector.h"
+#include "RowCompare.h"
+#include "MorselQueue.h"
+#include "SortRun.h"
 
 class Table;
 class Row;
+class Column;
 
 class TableIterator : public Iterator {
 public:
     unsigned n_columns() override;
     void open() override;
     Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
     void close() override;
 
 public:
@@ -22,6 +36,209 @@ private:
     Table* _table;
     RowList::iterator _end;
     RowList::iterator _input;
+    // For COLUMN_STORAGE
+    unsigned long _position;
+    unsigned long _n_rows;
+};
+
+class ColumnScan : public Iterator {
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+private:
+    bool selected(unsigned long position);
+    Row* materialize(unsigned long position);
+
+public:
+    ColumnScan(Table* table,
+               const initializer_list<unsigned>& columns,
+               int predicate_column,
+               ValuePredicate predicate);
+    ColumnScan(Table* table,
+               const initializer_list<unsigned>& columns,
+               int predicate_column,
+               const string& value);
+
+private:
+    Table* _table;
+    vector<const Column*> _columns;
+    const Column* _predicate_column;
+    // If there is a _predicate_column, then rows are selected by _predicate, or if that is NULL, by equality to
+    // _value, (compared using _value_code if the column is dictionary-encoded).
+    ValuePredicate _predicate;
+    string _value;
+    unsigned _value_code;
+    unsigned long _position;
+    unsigned long _n_rows;
+};
+
+class MorselScan : public Iterator {
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+    // Forget the morsels claimed, before the MorselQueue is reset
+    void restart();
+
+private:
+    bool next_morsel();
+    Row* row(unsigned long position);
+
+public:
+    MorselScan(Table* table, MorselQueue* morsels, unsigned worker);
+
+private:
+    Table* _table;
+    MorselQueue* _morsels;
+    unsigned _worker;
+    // The morsels claimed since restart, which are replayed if the scan is reopened, (e.g. as the left input of a
+    // nested_loops_join), and the number replayed by this scan so far
+    vector<pair<unsigned long, unsigned long>> _claimed;
+    unsigned long _replayed;
+    // The rest of the current morsel
+    unsigned long _position;
+    unsigned long _end;
+};
+
+// Runs a copy of a plan on each of several worker threads, returning the output rows of all the plans, in no
+// particular order. Subclasses build the plans, over inputs that divide the work among the workers.
+class Gather : public Iterator {
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+private:
+    void work(unsigned worker);
+    // Pass the rows of batch to the consumer, returning false, (having reclaimed the rows), if closing
+    bool deliver(RowBatch& batch);
+
+protected:
+    // Add a worker, which will run the given plan
+    void add_pipeline(Iterator* pipeline);
+
+protected:
+    Gather();
+    ~Gather();
+
+private:
+    vector<Iterator*> _pipelines;
+    vector<thread> _workers;
+    // Rows produced by the workers, not yet returned, and the number that may be waiting
+    deque<Row*> _rows;
+    unsigned long _capacity;
+    unsigned _n_running;
+    bool _closing;
+    // The first exception thrown by a worker, rethrown to the consumer
+    exception_ptr _error;
+    mutex _lock;
+    // Notified when _rows is added to, a worker finishes, or a worker fails
+    condition_variable _produced;
+    // Notified when _rows is removed from, or the Gather is closing
+    condition_variable _consumed;
+};
+
+class ParallelScan : public Gather {
+public:
+    void open() override;
+
+public:
+    ParallelScan(Table* table, unsigned n_threads, Pipeline pipeline, unsigned long morsel_size);
+
+private:
+    Table* _table;
+    MorselQueue _morsels;
+    vector<MorselScan*> _scans;
+};
+
+class ExchangePartition;
+
+// Divides its input among several workers, each running a copy of a plan over its partition, (read through an
+// ExchangePartition). Rows are partitioned round-robin, a batch at a time, or by a hash of the partition columns,
+// so that rows with equal values of those columns are in the same partition. The input is read on a thread of
+// its own.
+class Exchange : public Gather {
+public:
+    void open() override;
+    void close() override;
+
+private:
+    void distribute();
+    unsigned partition(const Row* row);
+    // Move rows to a partition, returning false, (leaving the rows), if closing
+    bool send(unsigned partition, vector<Row*>& rows);
+    unsigned receive(unsigned partition, RowBatch& batch);
+
+public:
+    Exchange(Iterator* input,
+             unsigned n_threads,
+             Pipeline pipeline,
+             const initializer_list<unsigned>& partition_columns,
+             bool rescannable);
+    ~Exchange();
+
+private:
+    Iterator* _input;
+    vector<unsigned> _partition_columns;
+    vector<ExchangePartition*> _partition_inputs;
+    thread _distributor;
+    // Rows sent to each partition, not yet received
+    vector<deque<Row*>> _partitions;
+    unsigned long _capacity;
+    bool _input_done;
+    // The exception thrown by the input, if any, rethrown by receive
+    exception_ptr _input_error;
+    bool _closing;
+    mutex _lock;
+    // Notified when a partition is added to, the input is done, or the Exchange is closing
+    condition_variable _sent;
+    // Notified when a partition is removed from, or the Exchange is closing
+    condition_variable _received;
+
+    friend class ExchangePartition;
+};
+
+// The input of a plan run by a worker of an Exchange
+class ExchangePartition : public Iterator {
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+    // Discard the rows received, once the Exchange's workers are done
+    void restart();
+
+private:
+    bool receive();
+    Row* output(Row* row);
+    void discard();
+
+public:
+    ExchangePartition(Exchange* exchange, unsigned partition, unsigned n_columns, bool rescannable);
+
+private:
+    Exchange* _exchange;
+    unsigned _partition;
+    unsigned _n_columns;
+    // Whether the partition may be reopened, (e.g. as the left input of a nested_loops_join), before restart
+    bool _rescannable;
+    bool _opened;
+    RowBatch _batch;
+    // If rescannable, the rows received since restart, which are replayed if the partition is reopened. Otherwise,
+    // the rows of the last batch received. And the position of the current pass.
+    vector<Row*> _received;
+    unsigned long _position;
 };
 
 class Select : public Iterator {
@@ -29,15 +246,25 @@ public:
     unsigned n_columns() override;
     void open() override;
     Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
     void close() override;
 
+private:
+    bool selected(const Row* row);
+
 public:
     Select(Iterator* input, RowPredicate predicate);
+    Select(Iterator* input, unsigned column, const string& value);
     ~Select();
 
 private:
     Iterator* _input;
+    // Rows are selected by _predicate, or if that is NULL, by equality of _column to _value, (compared using
+    // _value_code for rows having a code for _column).
     RowPredicate _predicate;
+    unsigned _column;
+    string _value;
+    unsigned _value_code;
 };
 
 class Project : public Iterator {
@@ -45,6 +272,8 @@ public:
     unsigned n_columns() override;
     void open() override;
     Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    const RowView* next_view() override;
     void close() override;
 
 public:
@@ -56,17 +285,40 @@ private:
     ColumnSelector _column_selector;
 };
 
-class NestedLoopsJoin: public Iterator
+class Join: public Iterator
 {
 public:
     unsigned n_columns() override;
-    void open() override;
+    // Joins produce views of their input rows, which next() and next_batch() materialize.
     Row* next() override;
-    void close() override;
+    unsigned next_batch(RowBatch& batch) override;
 
-private:
-    Row* join_rows(const Row* left, const Row* right);
+protected:
+    const RowView* join_views(const Row* left, const Row* right);
+    const RowView* join_views(const RowView* left, const RowView* right);
     bool match(const Row* left, const Row* right);
+    bool match(const RowView* left, const RowView* right);
+    // The values of the join columns, with their codes and native forms, so that keys compare as match does
+    Row left_key(const Row* left);
+    Row right_key(const Row* right);
+
+protected:
+    Join(unsigned n_left_columns,
+         const vector<unsigned>& left_join_columns,
+         unsigned n_right_columns,
+         const vector<unsigned>& right_join_columns);
+
+protected:
+    ColumnSelector _left_join_columns;
+    ColumnSelector _right_join_columns;
+};
+
+class NestedLoopsJoin: public Join
+{
+public:
+    void open() override;
+    const RowView* next_view() override;
+    void close() override;
 
 public:
     NestedLoopsJoin(Iterator* left,
@@ -78,9 +330,113 @@ public:
 private:
     Iterator* _left;
     Iterator* _right;
-    ColumnSelector _left_join_columns;
-    ColumnSelector _right_join_columns;
+    const RowView* _right_view;
+};
+
+class BlockNestedLoopsJoin: public Join
+{
+public:
+    void open() override;
+    const RowView* next_view() override;
+    void close() override;
+
+private:
+    void next_block();
+
+public:
+    BlockNestedLoopsJoin(Iterator* left,
+                         const initializer_list<unsigned>& left_join_columns,
+                         Iterator* right,
+                         const initializer_list<unsigned>& right_join_columns,
+                         unsigned block_size);
+    ~BlockNestedLoopsJoin();
+
+private:
+    Iterator* _left;
+    Iterator* _right;
+    unsigned _block_size;
+    vector<Row*> _block;
+    RowBatch _left_batch;
+    unsigned long _block_position;
+    Row* _right_row;
+};
+
+class HashJoin: public Join
+{
+public:
+    void open() override;
+    const RowView* next_view() override;
+    void close() override;
+
+public:
+    HashJoin(Iterator* left,
+             const initializer_list<unsigned>& left_join_columns,
+             Iterator* right,
+             const initializer_list<unsigned>& right_join_columns);
+    ~HashJoin();
+
+private:
+    Iterator* _left;
+    Iterator* _right;
+    // Left rows, by hash of join key, in input order. Keys are hashed as for HashIndex, and candidates are checked
+    // with match(). Keys are not compared directly because equality isn't transitive across typed and untyped
+    // values, e.g. typed "7" and "07" are equal, but untyped "7" equals only the first.
+    unordered_map<size_t, vector<Row*>> _left_rows;
+    RowBatch _right_batch;
+    unsigned long _right_position;
+    Row* _right_row;
+    const vector<Row*>* _matches;
+    unsigned long _match_position;
+};
+
+class MergeJoin: public Join
+{
+public:
+    void open() override;
+    const RowView* next_view() override;
+    void close() override;
+
+private:
+    void start_run();
+
+public:
+    MergeJoin(Iterator* left,
+              const initializer_list<unsigned>& left_join_columns,
+              Iterator* right,
+              const initializer_list<unsigned>& right_join_columns);
+    ~MergeJoin();
+
+private:
+    Iterator* _left;
+    Iterator* _right;
+    RowCompare _key_compare;
+    // Left rows whose join key matches that of _right_row
+    vector<Row*> _left_run;
+    unsigned long _run_position;
+    // First left row following _left_run
     Row* _left_row;
+    Row* _right_row;
+};
+
+class IndexJoin: public Join
+{
+public:
+    void open() override;
+    const RowView* next_view() override;
+    void close() override;
+
+public:
+    IndexJoin(Iterator* outer,
+              const initializer_list<unsigned>& outer_join_columns,
+              Index* index);
+    ~IndexJoin();
+
+private:
+    Iterator* _outer;
+    Index* _index;
+    Row* _outer_row;
+    Index::iterator _input;
+    Index::iterator _end;
 };
 
 class IndexScan: public Iterator
@@ -89,6 +445,7 @@ public:
     unsigned n_columns() override;
     void open() override;
     Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
     void close() override;
 
 public:
@@ -102,23 +459,101 @@ private:
     Index::iterator _end;
 };
 
+class HashIndexScan: public Iterator
+{
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+public:
+    HashIndexScan(HashIndex* index, Row* key);
+
+private:
+    HashIndex* _index;
+    Row* _key;
+    HashIndex::iterator _input;
+    HashIndex::iterator _end;
+};
+
 class Sort: public Iterator
 {
 public:
     unsigned n_columns() override;
     void open() override;
     Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
     void close() override;
 
 public:
-    Sort(Iterator* input, const initializer_list<unsigned>& sort_columns);
+    Sort(Iterator* input,
+         const initializer_list<unsigned>& sort_columns,
+         unsigned n_threads,
+         unsigned long memory_budget);
     ~Sort();
 
+private:
+    void sort_rows();
+    void spill();
+    void merge_push(unsigned run);
+    static unsigned long row_size(const Row* row);
+
 private:
     Iterator* _input;
     vector<unsigned> _sort_columns;
+    unsigned _n_threads;
+    unsigned long _memory_budget; // 0 if unlimited
+    unsigned long _sorted_size; // Estimated bytes in _sorted
     vector<Row*> _sorted;
     vector<Row*>::iterator _sorted_iterator;
+    // Spilled runs, if the memory budget was exceeded, and their next rows, which are merged
+    vector<SortRun*> _runs;
+    vector<Row*> _run_heads;
+    vector<unsigned> _merge_heap; // Runs with a head, ordered as a heap of their heads
+};
+
+class TopN: public Iterator
+{
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+public:
+    TopN(Iterator* input, const initializer_list<unsigned>& sort_columns, unsigned n);
+    ~TopN();
+
+private:
+    Iterator* _input;
+    vector<unsigned> _sort_columns;
+    unsigned _n;
+    // While open() consumes the input, a heap of the smallest rows seen, largest first. Then, those rows sorted.
+    vector<Row*> _top;
+    vector<Row*>::iterator _top_iterator;
+};
+
+class Limit: public Iterator
+{
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    const RowView* next_view() override;
+    void close() override;
+
+public:
+    Limit(Iterator* input, unsigned n);
+    ~Limit();
+
+private:
+    Iterator* _input;
+    unsigned _n;
+    unsigned _produced;
 };
 
 class Unique: public Iterator
@@ -127,6 +562,7 @@ public:
     unsigned n_columns() override;
     void open() override;
     Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
     void close() override;
 
 public:
@@ -137,3 +573,95 @@ private:
     Iterator* _input;
     Row* _next_unique;
 };
+
+class HashDistinct: public Iterator
+{
+public:
+    unsigned n_columns() override;
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+private:
+    bool first(const Row* row);
+
+public:
+    explicit HashDistinct(Iterator* input);
+    ~HashDistinct();
+
+private:
+    Iterator* _input;
+    // Copies of the rows produced so far
+    unordered_set<Row, HashIndexKeyHash, HashIndexKeyEqual> _seen;
+};
+
+// Base class of aggregation operators, which produce a row for each group of input rows, containing the group
+// columns followed by the aggregates
+class Aggregation: public Iterator
+{
+public:
+    unsigned n_columns() override;
+
+protected:
+    // A new output row for the group of row, with initial aggregate values. Until finish is called, the values of
+    // COUNT_AGGREGATE and SUM_AGGREGATE columns are kept only in their native forms.
+    Row* new_group(const Row* row);
+    void accumulate(Row* group, const Row* row);
+    void finish(Row* group);
+    // Whether row belongs to the group of the given output row
+    bool in_group(const Row* group, const Row* row);
+
+protected:
+    Aggregation(Iterator* input,
+                const initializer_list<unsigned>& group_columns,
+                const initializer_list<Aggregate>& aggregates);
+    ~Aggregation();
+
+protected:
+    Iterator* _input;
+    vector<unsigned> _group_columns;
+    vector<Aggregate> _aggregates;
+};
+
+class HashAggregate: public Aggregation
+{
+public:
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+private:
+    Row* group(const Row* row);
+
+public:
+    HashAggregate(Iterator* input,
+                  const initializer_list<unsigned>& group_columns,
+                  const initializer_list<Aggregate>& aggregates);
+
+private:
+    // Output rows, in order of the groups' first occurrence
+    vector<Row*> _groups;
+    vector<Row*>::iterator _groups_iterator;
+    // Output rows, by group key
+    unordered_map<Row, Row*, HashIndexKeyHash, HashIndexKeyEqual> _groups_by_key;
+};
+
+class SortedAggregate: public Aggregation
+{
+public:
+    void open() override;
+    Row* next() override;
+    unsigned next_batch(RowBatch& batch) override;
+    void close() override;
+
+public:
+    SortedAggregate(Iterator* input,
+                    const initializer_list<unsigned>& group_columns,
+                    const initializer_list<Aggregate>& aggregates);
+
+private:
+    // The first input row of the next group, or NULL if the input is exhausted
+    Row* _next_row;
+};
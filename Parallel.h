@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Call f(begin, end) for each of up to n_threads consecutive ranges partitioning [0, n), each range on its own
+// thread. With one thread, (or one range), f is called on the calling thread.
+template <class Function>
+void parallel_for(unsigned long n, unsigned n_threads, Function f)
+{
+    unsigned long n_ranges = max(1UL, min((unsigned long) n_threads, n));
+    if (n_ranges == 1) {
+        f(0UL, n);
+        return;
+    }
+    vector<thread> threads;
+    for (unsigned long i = 0; i < n_ranges; i++) {
+        threads.emplace_back(f, n * i / n_ranges, n * (i + 1) / n_ranges);
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+}
+
+// Sort [begin, end) stably, as std::stable_sort does, using up to n_threads threads. Consecutive runs are sorted
+// concurrently, and then adjacent runs are merged pairwise, each round of merges also running concurrently.
+template <class RandomIterator, class Compare>
+void parallel_stable_sort(RandomIterator begin, RandomIterator end, Compare compare, unsigned n_threads)
+{
+    unsigned long n = (unsigned long) (end - begin);
+    unsigned long n_runs = max(1UL, min((unsigned long) n_threads, n));
+    vector<unsigned long> bounds;
+    for (unsigned long i = 0; i <= n_runs; i++) {
+        bounds.emplace_back(n * i / n_runs);
+    }
+    parallel_for(n_runs, n_threads, [&](unsigned long first_run, unsigned long end_run) {
+        for (unsigned long run = first_run; run < end_run; run++) {
+            stable_sort(begin + bounds[run], begin + bounds[run + 1], compare);
+        }
+    });
+    // Merging the left run before the right one keeps equal elements in order.
+    for (unsigned long width = 1; width < n_runs; width *= 2) {
+        unsigned long n_merges = (n_runs + 2 * width - 1) / (2 * width);
+        parallel_for(n_merges, n_threads, [&](unsigned long first_merge, unsigned long end_merge) {
+            for (unsigned long merge = first_merge; merge < end_merge; merge++) {
+                unsigned long left = merge * 2 * width;
+                unsigned long middle = min(left + width, n_runs);
+                unsigned long right = min(left + 2 * width, n_runs);
+                inplace_merge(begin + bounds[left], begin + bounds[middle], begin + bounds[right], compare);
+            }
+        });
+    }
+}
@@ -5,11 +5,51 @@ Iterator* table_scan(Table* table)
     return new TableIterator(table);
 }
 
+Iterator* column_scan(Table* table,
+                      const initializer_list<unsigned>& columns,
+                      int predicate_column,
+                      ValuePredicate predicate)
+{
+    return new ColumnScan(table, columns, predicate_column, predicate);
+}
+
+Iterator* column_scan(Table* table,
+                      const initializer_list<unsigned>& columns,
+                      int predicate_column,
+                      const string& value)
+{
+    return new ColumnScan(table, columns, predicate_column, value);
+}
+
+Iterator* parallel_scan(Table* table, unsigned n_threads, Pipeline pipeline, unsigned long morsel_size)
+{
+    return new ParallelScan(table, n_threads, pipeline, morsel_size);
+}
+
+Iterator* exchange(Iterator* input, unsigned n_threads, Pipeline pipeline, bool rescannable)
+{
+    return new Exchange(input, n_threads, pipeline, {}, rescannable);
+}
+
+Iterator* exchange(Iterator* input,
+                   unsigned n_threads,
+                   Pipeline pipeline,
+                   const initializer_list<unsigned>& partition_columns,
+                   bool rescannable)
+{
+    return new Exchange(input, n_threads, pipeline, partition_columns, rescannable);
+}
+
 Iterator* select(Iterator* input, RowPredicate predicate)
 {
     return new Select(input, predicate);
 }
 
+Iterator* select(Iterator* input, unsigned column, const string& value)
+{
+    return new Select(input, column, value);
+}
+
 Iterator* project(Iterator* input, initializer_list<unsigned> project_columns)
 {
     return new Project(input, project_columns);
@@ -23,17 +63,86 @@ Iterator* nested_loops_join(Iterator* left,
     return new NestedLoopsJoin(left, left_columns, right, right_columns);
 }
 
+Iterator* block_nested_loops_join(Iterator* left,
+                                  const initializer_list<unsigned>& left_columns,
+                                  Iterator* right,
+                                  const initializer_list<unsigned>& right_columns,
+                                  unsigned block_size)
+{
+    return new BlockNestedLoopsJoin(left, left_columns, right, right_columns, block_size);
+}
+
+Iterator* hash_join(Iterator* left,
+                    const initializer_list<unsigned>& left_columns,
+                    Iterator* right,
+                    const initializer_list<unsigned>& right_columns)
+{
+    return new HashJoin(left, left_columns, right, right_columns);
+}
+
+Iterator* merge_join(Iterator* left,
+                     const initializer_list<unsigned>& left_columns,
+                     Iterator* right,
+                     const initializer_list<unsigned>& right_columns)
+{
+    return new MergeJoin(left, left_columns, right, right_columns);
+}
+
+Iterator* index_join(Iterator* outer,
+                     const initializer_list<unsigned>& outer_columns,
+                     Index* index)
+{
+    return new IndexJoin(outer, outer_columns, index);
+}
+
 Iterator* index_scan(Index* index, Row* lo, Row* hi)
 {
     return new IndexScan(index, lo, hi);
 }
 
-Iterator* sort(Iterator* input, const initializer_list<unsigned>& sort_columns)
+Iterator* hash_index_scan(HashIndex* index, Row* key)
+{
+    return new HashIndexScan(index, key);
+}
+
+Iterator* sort(Iterator* input,
+               const initializer_list<unsigned>& sort_columns,
+               unsigned n_threads,
+               unsigned long memory_budget)
+{
+    return new Sort(input, sort_columns, n_threads, memory_budget);
+}
+
+Iterator* top_n(Iterator* input, const initializer_list<unsigned>& sort_columns, unsigned n)
 {
-    return new Sort(input, sort_columns);
+    return new TopN(input, sort_columns, n);
+}
+
+Iterator* limit(Iterator* input, unsigned n)
+{
+    return new Limit(input, n);
 }
 
 Iterator* unique(Iterator* input)
 {
     return new Unique(input);
+}
+
+Iterator* hash_distinct(Iterator* input)
+{
+    return new HashDistinct(input);
+}
+
+Iterator* hash_aggregate(Iterator* input,
+                         const initializer_list<unsigned>& group_columns,
+                         const initializer_list<Aggregate>& aggregates)
+{
+    return new HashAggregate(input, group_columns, aggregates);
+}
+
+Iterator* sorted_aggregate(Iterator* input,
+                           const initializer_list<unsigned>& group_columns,
+                           const initializer_list<Aggregate>& aggregates)
+{
+    return new SortedAggregate(input, group_columns, aggregates);
 }
\ No newline at end of file
@@ -1,18 +1,83 @@
 #pragma once
 
+#include "Aggregate.h"
 #include "Row.h"
+#include "Iterator.h"
+#include "MorselQueue.h"
 
 class Iterator;
 class Table;
 class Index;
+class HashIndex;
 
 using namespace std;
 
 /*
- * Return an iterator that scans that rows of the given table.
+ * Return an iterator that scans that rows of the given table. For a table with COLUMN_STORAGE, the rows are
+ * materialized from the columns, and are intermediate rows.
  */
 Iterator* table_scan(Table* table);
 
+/*
+ * Return an iterator that scans a table with COLUMN_STORAGE, reading only the given columns, and returning rows
+ * containing just those columns, (as would project(table_scan(table), columns)). If predicate is given, only
+ * rows for which predicate is true of the value of predicate_column are returned. The predicate is evaluated on
+ * the column before anything else is read.
+ */
+Iterator* column_scan(Table* table,
+                      const initializer_list<unsigned>& columns,
+                      int predicate_column = -1,
+                      ValuePredicate predicate = NULL);
+
+/*
+ * Like column_scan with a predicate, but returning only rows in which predicate_column is equal to value. If
+ * predicate_column is dictionary-encoded, then value is looked up in the dictionary once, and codes are compared
+ * instead of strings.
+ */
+Iterator* column_scan(Table* table,
+                      const initializer_list<unsigned>& columns,
+                      int predicate_column,
+                      const string& value);
+
+/*
+ * Return an iterator that scans the given table on n_threads threads. The table is divided into morsels of
+ * morsel_size consecutive rows, which the threads claim, (stealing them from each other to balance the work). Each
+ * thread runs its own copy of the plan built by pipeline, (e.g. a select and project), over the rows of the
+ * morsels it claims, and the output rows of all threads are returned in no particular order. If pipeline is NULL,
+ * the table's rows are returned. A pipeline may rescan its input, (as nested_loops_join does its left input): each
+ * pass replays the morsels claimed by earlier passes, and then claims more, so that a pass reading its input to the
+ * end sees all of its thread's rows. A pass must read to the end before a rescan, or rows claimed afterwards are
+ * missed by that pass. If a thread's plan throws an exception, the other threads stop, and the exception is
+ * rethrown by next and next_batch.
+ */
+Iterator* parallel_scan(Table* table,
+                        unsigned n_threads,
+                        Pipeline pipeline = NULL,
+                        unsigned long morsel_size = MorselQueue::DEFAULT_MORSEL_SIZE);
+
+/*
+ * Return an iterator that runs a copy of the plan built by pipeline on each of n_threads threads. The rows of
+ * input are divided among the threads round-robin, a batch at a time, and each copy of the plan reads the rows of
+ * its thread. The output rows of all threads are returned in no particular order. E.g., with a pipeline that
+ * joins its input to a table, the join runs on all threads, each building its own copy of any hash table. Rows
+ * are passed to the plans as they are read, and a plan may read its input only once per opening of the exchange,
+ * unless rescannable is true. Then a plan may rescan its input, (as nested_loops_join does its left input): each
+ * thread keeps the rows it has read until the exchange is closed, and a rescan replays them before reading more. A
+ * pass must read to the end before a rescan, or rows read afterwards are missed by that pass. An exception thrown
+ * by input, or by a thread's plan, stops the exchange, and is rethrown by next and next_batch.
+ */
+Iterator* exchange(Iterator* input, unsigned n_threads, Pipeline pipeline, bool rescannable = false);
+
+/*
+ * Like exchange, but dividing the rows of input by a hash of the values of partition_columns, so that rows with
+ * equal values of those columns are read by the same thread, (as needed e.g. for a pipeline using unique).
+ */
+Iterator* exchange(Iterator* input,
+                   unsigned n_threads,
+                   Pipeline pipeline,
+                   const initializer_list<unsigned>& partition_columns,
+                   bool rescannable = false);
+
 /*
  * Return an iterator that scans the rows of the table identified by a search of the index.
  * The index scan begins at the first key >= lo, and ends at the last row <= hi. If hi is omitted,
@@ -20,11 +85,24 @@ Iterator* table_scan(Table* table);
  */
 Iterator* index_scan(Index* index, Row* lo, Row* hi = NULL);
 
+/*
+ * Return an iterator that scans the rows of the table whose key columns are equal to key, found by a lookup in
+ * the hash index. Unlike index_scan, key must contain a value for every key column, and ranges are not supported.
+ */
+Iterator* hash_index_scan(HashIndex* index, Row* key);
+
 /*
  * Return an iterator including only those input rows that satisfy the given predicate.
  */
 Iterator* select(Iterator* input, RowPredicate predicate);
 
+/*
+ * Return an iterator including only those input rows in which the given column is equal to value. For rows in
+ * which the column's value is dictionary-encoded, (e.g. rows scanned from an encoded column), codes are
+ * compared instead of strings.
+ */
+Iterator* select(Iterator* input, unsigned column, const string& value);
+
 /*
  * Return an iterator whose rows contain only the columns specified in project_columns.
  * Duplicates are NOT eliminated.
@@ -45,12 +123,104 @@ Iterator* nested_loops_join(Iterator* left,
                             const initializer_list<unsigned>& right_columns);
 
 /*
- * Return an iterator sorting by the columns specified in sort_columns.
+ * Return an iterator containing the join of rows in left and right, computed by reading left in blocks of up to
+ * block_size rows, and comparing each right row with every row of the block. left is scanned once, and right is
+ * scanned once per block. The join columns and the output rows are as for nested_loops_join. If all of left fits
+ * in one block, then the output rows are produced in the same order as by nested_loops_join.
+ */
+Iterator* block_nested_loops_join(Iterator* left,
+                                  const initializer_list<unsigned>& left_columns,
+                                  Iterator* right,
+                                  const initializer_list<unsigned>& right_columns,
+                                  unsigned block_size);
+
+/*
+ * Return an iterator containing the join of rows in left and right, computed by building a hash table on the
+ * join columns of left, and then probing it with each row of right. The join columns and the output rows are as
+ * for nested_loops_join, and the output rows are produced in the same order.
  */
-Iterator* sort(Iterator* input, const initializer_list<unsigned>& sort_columns);
+Iterator* hash_join(Iterator* left,
+                    const initializer_list<unsigned>& left_columns,
+                    Iterator* right,
+                    const initializer_list<unsigned>& right_columns);
+
+/*
+ * Return an iterator containing the join of rows in left and right, computed by merging inputs that are both
+ * sorted on their join columns, (e.g. by sort, or by an index_scan of an index on the join columns). The join
+ * columns and the output rows are as for nested_loops_join. The output is sorted on the join columns.
+ */
+Iterator* merge_join(Iterator* left,
+                     const initializer_list<unsigned>& left_columns,
+                     Iterator* right,
+                     const initializer_list<unsigned>& right_columns);
+
+/*
+ * Return an iterator containing the join of rows in outer with the rows of the table indexed by index. Each
+ * outer row is joined with the indexed rows found by looking up the outer row's outer_columns in the index, so
+ * outer_columns correspond, in order, to the index's columns. The output rows contain all the columns of outer,
+ * followed by the non-key columns of the indexed table, as for
+ * nested_loops_join(outer, outer_columns, table_scan(table), <index columns>).
+ */
+Iterator* index_join(Iterator* outer,
+                     const initializer_list<unsigned>& outer_columns,
+                     Index* index);
+
+/*
+ * Return an iterator sorting by the columns specified in sort_columns. If n_threads is greater than 1, then runs
+ * of the input are sorted on that many threads, and then merged, also in parallel. The order of rows with equal
+ * sort columns is not specified, in either case.
+ *
+ * If memory_budget is not 0, then it limits the estimated bytes of input rows held at once. Whenever the budget is
+ * exceeded, the rows held are sorted and spilled, as a run, to a temporary file; the runs are then merged as output
+ * rows are requested. Rows read back from a run are intermediate rows, with the codes and native forms of their
+ * values, but not their table.
+ */
+Iterator* sort(Iterator* input,
+               const initializer_list<unsigned>& sort_columns,
+               unsigned n_threads = 1,
+               unsigned long memory_budget = 0);
+
+/*
+ * Return an iterator producing the first n rows of sort(input, sort_columns), in that order. Only n input rows are
+ * held at once, so this is much cheaper than a sort when n is small.
+ */
+Iterator* top_n(Iterator* input, const initializer_list<unsigned>& sort_columns, unsigned n);
+
+/*
+ * Return an iterator producing the first n rows of input. Once n rows have been produced, no more are requested
+ * from input.
+ */
+Iterator* limit(Iterator* input, unsigned n);
 
 /*
  * Return an iterator eliminating duplicates. This implementation assumes that the input is sorted, which
  * causes duplicates to be adjacent.
  */
 Iterator* unique(Iterator* input);
+
+/*
+ * Return an iterator eliminating duplicates, without requiring sorted input. Each distinct row is produced the first
+ * time it occurs, so the input order is preserved. A copy of each distinct row is kept until close.
+ */
+Iterator* hash_distinct(Iterator* input);
+
+/*
+ * Return an iterator grouping the input rows by the columns specified in group_columns, and computing the given
+ * aggregates over each group. Each output row contains the group columns, followed by one column for each aggregate.
+ * COUNT_AGGREGATE and SUM_AGGREGATE produce integers, (with native forms); MIN_AGGREGATE and MAX_AGGREGATE produce
+ * values of their column, compared as for sort. Groups are produced in the order in which they first occur in the
+ * input, (so with no group columns, an empty input produces no rows). SUM_AGGREGATE throws TableException for a
+ * value that isn't an integer.
+ */
+Iterator* hash_aggregate(Iterator* input,
+                         const initializer_list<unsigned>& group_columns,
+                         const initializer_list<Aggregate>& aggregates);
+
+/*
+ * Like hash_aggregate, but assuming that the input is sorted on the group columns, (e.g. by sort, or by an
+ * index_scan of an index on those columns), so that each group's rows are adjacent. Each group is produced as soon
+ * as the following group starts, and only one group is held at a time.
+ */
+Iterator* sorted_aggregate(Iterator* input,
+                           const initializer_list<unsigned>& group_columns,
+                           const initializer_list<Aggregate>& aggregates);
@@ -1,6 +1,8 @@
 #include <cassert>
 #include <cstring>
+#include <functional>
 #include "Database.h"
+#include "RowArena.h"
 
 const Table *Row::table() const
 {
@@ -22,9 +24,114 @@ const string &Row::value(const string &column) const
 
 void Row::append(const string &value)
 {
+    append(value, Dictionary::NO_CODE, NO_NATIVE);
+}
+
+void Row::append(const char *value, size_t length)
+{
+    if (!_codes.empty()) {
+        _codes.emplace_back(Dictionary::NO_CODE);
+    }
+    if (!_natives.empty()) {
+        _natives.emplace_back(NO_NATIVE);
+    }
+    emplace_back(value, length);
+}
+
+void Row::append(const string &value, unsigned code, long native)
+{
+    if (!_codes.empty() || code != Dictionary::NO_CODE) {
+        _codes.resize(size(), Dictionary::NO_CODE);
+        _codes.emplace_back(code);
+    }
+    if (!_natives.empty() || native != NO_NATIVE) {
+        _natives.resize(size(), NO_NATIVE);
+        _natives.emplace_back(native);
+    }
     emplace_back(value);
 }
 
+void Row::append(const Row* row, unsigned column)
+{
+    append(row->at(column), row->code(column), row->native(column));
+}
+
+unsigned Row::code(unsigned column) const
+{
+    return _codes.empty() ? Dictionary::NO_CODE : _codes[column];
+}
+
+long Row::native(unsigned column) const
+{
+    return _natives.empty() ? NO_NATIVE : _natives[column];
+}
+
+void Row::set_native(unsigned column, long native)
+{
+    _natives.resize(size(), NO_NATIVE);
+    _natives[column] = native;
+}
+
+void Row::set_code(unsigned column, unsigned code)
+{
+    _codes.resize(size(), Dictionary::NO_CODE);
+    _codes[column] = code;
+}
+
+int Row::compare(unsigned column, const Row* other, unsigned other_column) const
+{
+    long x = native(column);
+    long y = other->native(other_column);
+    if (x != NO_NATIVE && y != NO_NATIVE) {
+        return x < y ? -1 : x > y ? 1 : 0;
+    }
+    return strcmp(at(column).c_str(), other->at(other_column).c_str());
+}
+
+bool Row::equal(unsigned column, const Row* other, unsigned other_column) const
+{
+    long x = native(column);
+    long y = other->native(other_column);
+    if (x != NO_NATIVE && y != NO_NATIVE) {
+        return x == y;
+    }
+    // Codes are from the Database's Dictionary, so if both values are encoded, comparing the codes suffices.
+    unsigned x_code = code(column);
+    unsigned y_code = other->code(other_column);
+    if (x_code != Dictionary::NO_CODE && y_code != Dictionary::NO_CODE) {
+        return x_code == y_code;
+    }
+    return at(column) == other->at(other_column);
+}
+
+bool Row::equal(const Row* other) const
+{
+    unsigned n = (unsigned) size();
+    if (n != other->size()) {
+        return false;
+    }
+    for (unsigned i = 0; i < n; i++) {
+        if (!equal(i, other, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Row::hash(unsigned column) const
+{
+    // Typed values that are equal have equal native forms, but their strings may differ, e.g. "07" and "7". A
+    // typed value is also equal to an untyped value with the same string (see equal), so an untyped value that
+    // parses as a typed one is hashed by the native form it would have.
+    long x = native(column);
+    if (x != NO_NATIVE ||
+        parse_native(INTEGER_COLUMN, at(column), x) ||
+        parse_native(DATE_COLUMN, at(column), x)) {
+        return std::hash<long>()(x);
+    }
+    return std::hash<string>()(at(column));
+}
+
 bool Row::is_intermediate_row() const
 {
     return _table == NULL;
@@ -52,6 +159,41 @@ Row::~Row()
 void Row::reclaim(Row* row)
 {
     if (row && row->is_intermediate_row()) {
-        delete row;
+        RowArena::current()->free(row);
     }
 }
+
+Row* Row::make_intermediate()
+{
+    return RowArena::current()->allocate();
+}
+
+void Row::reset()
+{
+    clear();
+    _codes.clear();
+    _natives.clear();
+}
+
+const unsigned RowBatch::DEFAULT_SIZE_LIMIT;
+
+unsigned RowBatch::size_limit() const
+{
+    return _size_limit;
+}
+
+void RowBatch::set_size_limit(unsigned size_limit)
+{
+    _size_limit = size_limit;
+}
+
+bool RowBatch::full() const
+{
+    return size() >= _size_limit;
+}
+
+RowBatch::RowBatch(unsigned size_limit)
+    : _size_limit(size_limit)
+{
+    reserve(size_limit);
+}
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include "ColumnNames.h"
 
 using namespace std;
 
@@ -19,6 +20,45 @@ public:
     // Append a value to this Row
     void append(const string& value);
 
+    // Append a value to this Row, given as length characters starting at value
+    void append(const char* value, size_t length);
+
+    // Append a value to this Row, along with its code in the Database's Dictionary, and its native form
+    void append(const string& value, unsigned code, long native = NO_NATIVE);
+
+    // Append the value, code and native form in the given column of row
+    void append(const Row* row, unsigned column);
+
+    // The code, in the Database's Dictionary, of the value in the given column, or Dictionary::NO_CODE if it isn't
+    // known. Rows scanned from dictionary-encoded columns have codes, which are carried along by projections and
+    // joins.
+    unsigned code(unsigned column) const;
+
+    // The native form of the value in the given column, or NO_NATIVE if it isn't known. Rows of tables with typed
+    // columns have native forms, which are carried along by projections and joins.
+    long native(unsigned column) const;
+
+    // Set the native form of the value in the given column
+    void set_native(unsigned column, long native);
+
+    // Set the code, in the Database's Dictionary, of the value in the given column
+    void set_code(unsigned column, unsigned code);
+
+    // Compare the value in the given column with the value in other_column of other, returning a negative number,
+    // zero, or a positive number, as for strcmp. Native forms are compared if both values have them.
+    int compare(unsigned column, const Row* other, unsigned other_column) const;
+
+    // Whether the value in the given column is equal to the value in other_column of other. Native forms, or
+    // codes, are compared if both values have them.
+    bool equal(unsigned column, const Row* other, unsigned other_column) const;
+
+    // A hash of the value in the given column, consistent with equal: values that are equal have equal hashes
+    size_t hash(unsigned column) const;
+
+    // Whether this Row has the same number of values as other, each equal, as above, to the corresponding value
+    // of other
+    bool equal(const Row* other) const;
+
     // Create a Row for the given Table
     Row(const Table *table);
 
@@ -30,15 +70,53 @@ public:
     // Create a Row literal
     Row(const initializer_list<string>& values);
 
+    Row(const Row& row) = default;
+    Row(Row&& row) = default;
+    Row& operator=(const Row& row) = default;
+    Row& operator=(Row&& row) = default;
+
     // Destroy this Row
     ~Row();
 
 public:
+    // Dispose of a row that is no longer needed. Intermediate rows are returned to the current RowArena.
     static void reclaim(Row*);
 
+    // A Row for a query processing result, reusing one from the current RowArena if possible
+    static Row* make_intermediate();
+
+private:
+    // Remove all values, (freeing their strings), keeping the capacity of the vectors, so that this Row can be reused
+    void reset();
+
+    friend class RowArena;
+
 private:
     const Table *_table; // NULL for a query processing result
+    vector<unsigned> _codes; // Parallel to the values, or empty if no value has a code
+    vector<long> _natives; // Parallel to the values, or empty if no value has a native form
 };
 
 typedef bool (*RowPredicate)(const Row*);
+typedef bool (*ValuePredicate)(const string&);
 class RowList: public vector<Row*> {};
+
+// Rows produced together by Iterator::next_batch
+class RowBatch: public vector<Row*>
+{
+public:
+    // The maximum number of rows in this batch
+    unsigned size_limit() const;
+
+    void set_size_limit(unsigned size_limit);
+
+    bool full() const;
+
+    explicit RowBatch(unsigned size_limit = DEFAULT_SIZE_LIMIT);
+
+public:
+    static const unsigned DEFAULT_SIZE_LIMIT = 1024;
+
+private:
+    unsigned _size_limit;
+};
@@ -0,0 +1,63 @@
+#include "Row.h"
+#include "RowArena.h"
+
+thread_local RowArena* RowArena::_current = NULL;
+
+Row* RowArena::allocate()
+{
+    Row* row;
+    if (_rows.empty()) {
+        row = new Row();
+    } else {
+        row = _rows.back();
+        _rows.pop_back();
+    }
+    return row;
+}
+
+void RowArena::free(Row* row)
+{
+    if (_rows.size() < MAX_SIZE) {
+        row->reset();
+        _rows.emplace_back(row);
+    } else {
+        delete row;
+    }
+}
+
+unsigned long RowArena::size() const
+{
+    return _rows.size();
+}
+
+void RowArena::release()
+{
+    for (Row* row : _rows) {
+        delete row;
+    }
+    _rows.clear();
+}
+
+RowArena::RowArena()
+    : _previous(current())
+{
+    _current = this;
+}
+
+RowArena::RowArena(RowArena* previous)
+    : _previous(previous)
+{}
+
+RowArena::~RowArena()
+{
+    release();
+    if (_current == this) {
+        _current = _previous;
+    }
+}
+
+RowArena* RowArena::current()
+{
+    static thread_local RowArena thread_arena(NULL);
+    return _current == NULL ? &thread_arena : _current;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+class Row;
+
+// A pool of intermediate Rows. Row::reclaim returns intermediate rows to the current thread's arena, and
+// Row::make_intermediate reuses them, so that a running query allocates fewer Rows and vectors. Only the Row objects,
+// and the capacity of their vectors, are pooled: the strings of their values are freed when a row is returned, and
+// allocated again, (unless short enough to be stored inline), as values are appended. Pooled rows are freed together
+// when the arena is destroyed. Each thread has a default arena. Creating a RowArena
+// makes it the current thread's arena until it is destroyed, e.g. to release a query's rows when it completes.
+class RowArena
+{
+public:
+    // A cleared intermediate Row, reused from this arena if possible
+    Row* allocate();
+
+    // Keep the given intermediate row for reuse
+    void free(Row* row);
+
+    // The number of rows available for reuse
+    unsigned long size() const;
+
+    // Free all rows kept for reuse
+    void release();
+
+    RowArena();
+
+    ~RowArena();
+
+public:
+    // The current thread's arena
+    static RowArena* current();
+
+    // The maximum number of rows kept for reuse by an arena
+    static const unsigned long MAX_SIZE = 4096;
+
+private:
+    explicit RowArena(RowArena* previous);
+
+private:
+    vector<Row*> _rows;
+    RowArena* _previous;
+    static thread_local RowArena* _current;
+};
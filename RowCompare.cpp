@@ -3,17 +3,27 @@
 #include "RowCompare.h"
 
 RowCompare::RowCompare(const vector<unsigned>& sort_columns)
-    : _sort_columns(sort_columns)
+    : _sort_columns(sort_columns),
+      _y_sort_columns(sort_columns)
+{}
+
+RowCompare::RowCompare(const vector<unsigned>& x_sort_columns, const vector<unsigned>& y_sort_columns)
+    : _sort_columns(x_sort_columns),
+      _y_sort_columns(y_sort_columns)
 {}
 
 int RowCompare::operator()(Row* const &x, Row* const &y)
 {
-    unsigned n = (unsigned) x->size();
+    return compare(x, y) < 0;
+}
+
+int RowCompare::compare(const Row* x, const Row* y) const
+{
+    unsigned n = (unsigned) _sort_columns.size();
     for (unsigned i = 0; i < n; i++) {
-        unsigned j = _sort_columns.at(i);
-        int comparison = strcmp(x->at(j).c_str(), y->at(j).c_str());
+        int comparison = x->compare(_sort_columns[i], y, _y_sort_columns[i]);
         if (comparison != 0) {
-            return comparison < 0;
+            return comparison;
         }
     }
     return 0;
@@ -11,8 +11,14 @@ class RowCompare
 public:
     int operator()(Row* const &x, Row* const &y);
     bool cmp(Row* const &x, Row* const &y);
+    // Compare the sort columns of x with the corresponding sort columns of y, returning a negative number, zero,
+    // or a positive number, as for strcmp.
+    int compare(const Row* x, const Row* y) const;
     RowCompare(const vector<unsigned>& sort_columns);
+    // Compare x_sort_columns of one row with y_sort_columns of another, e.g. the join columns of two join inputs.
+    RowCompare(const vector<unsigned>& x_sort_columns, const vector<unsigned>& y_sort_columns);
 
 private:
     vector<unsigned> _sort_columns;
+    vector<unsigned> _y_sort_columns;
 };
@@ -0,0 +1,54 @@
+#include "Row.h"
+#include "RowView.h"
+
+unsigned RowView::size() const
+{
+    return (unsigned) _references.size();
+}
+
+const string& RowView::at(unsigned column) const
+{
+    const Reference& reference = _references.at(column);
+    return reference.row->at(reference.column);
+}
+
+const Row* RowView::row(unsigned column) const
+{
+    return _references.at(column).row;
+}
+
+unsigned RowView::row_column(unsigned column) const
+{
+    return _references.at(column).column;
+}
+
+bool RowView::equal(unsigned column, const RowView* other, unsigned other_column) const
+{
+    const Reference& x = _references.at(column);
+    const Reference& y = other->_references.at(other_column);
+    return x.row->equal(x.column, y.row, y.column);
+}
+
+void RowView::append(const Row* row, unsigned column)
+{
+    _references.push_back(Reference{row, column});
+}
+
+void RowView::append(const RowView* view, unsigned column)
+{
+    _references.push_back(view->_references.at(column));
+}
+
+void RowView::clear()
+{
+    _references.clear();
+}
+
+Row* RowView::materialize() const
+{
+    Row* row = Row::make_intermediate();
+    for (const Reference& reference : _references) {
+        row->append(reference.row, reference.column);
+    }
+    return row;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Row;
+
+// A row whose values are those in columns of other Rows, referred to rather than copied. Iterator::next_view
+// returns RowViews, so that projections and joins can pass values along without copying them. A RowView is only
+// valid while the Rows it refers to are.
+class RowView
+{
+public:
+    // The number of values in this view
+    unsigned size() const;
+
+    // The value in the given column
+    const string& at(unsigned column) const;
+
+    // The Row containing the value in the given column
+    const Row* row(unsigned column) const;
+
+    // The column of row(column) containing the value in the given column
+    unsigned row_column(unsigned column) const;
+
+    // Whether the value in the given column is equal to the value in other_column of other, as for Row::equal
+    bool equal(unsigned column, const RowView* other, unsigned other_column) const;
+
+    // Append a reference to the value in the given column of row
+    void append(const Row* row, unsigned column);
+
+    // Append the reference in the given column of view
+    void append(const RowView* view, unsigned column);
+
+    // Remove all references
+    void clear();
+
+    // An intermediate Row containing copies of the values referred to, along with their codes and native forms
+    Row* materialize() const;
+
+private:
+    struct Reference
+    {
+        const Row* row;
+        unsigned column;
+    };
+
+    vector<Reference> _references;
+};
@@ -0,0 +1,73 @@
+#include "Row.h"
+#include "SortRun.h"
+#include "dbexceptions.h"
+
+// Each row is written as its number of values, followed by each value's length, characters, code and native form.
+
+void SortRun::write(const Row* row)
+{
+    unsigned n = (unsigned) row->size();
+    bool written = fwrite(&n, sizeof(n), 1, _file) == 1;
+    for (unsigned i = 0; written && i < n; i++) {
+        const string& value = row->at(i);
+        unsigned long length = value.size();
+        unsigned code = row->code(i);
+        long native = row->native(i);
+        written =
+            fwrite(&length, sizeof(length), 1, _file) == 1 &&
+            fwrite(value.data(), 1, length, _file) == length &&
+            fwrite(&code, sizeof(code), 1, _file) == 1 &&
+            fwrite(&native, sizeof(native), 1, _file) == 1;
+    }
+    if (!written) {
+        throw DBException("Can't write sort run");
+    }
+}
+
+void SortRun::rewind()
+{
+    fflush(_file);
+    ::rewind(_file);
+}
+
+Row* SortRun::read()
+{
+    unsigned n;
+    if (fread(&n, sizeof(n), 1, _file) != 1) {
+        return NULL;
+    }
+    Row* row = Row::make_intermediate();
+    string value;
+    for (unsigned i = 0; i < n; i++) {
+        unsigned long length;
+        unsigned code;
+        long native;
+        bool read = fread(&length, sizeof(length), 1, _file) == 1;
+        if (read) {
+            value.resize(length);
+            read =
+                fread(&value[0], 1, length, _file) == length &&
+                fread(&code, sizeof(code), 1, _file) == 1 &&
+                fread(&native, sizeof(native), 1, _file) == 1;
+        }
+        if (!read) {
+            Row::reclaim(row);
+            throw DBException("Can't read sort run");
+        }
+        row->append(value, code, native);
+    }
+    return row;
+}
+
+SortRun::SortRun()
+    : _file(tmpfile())
+{
+    if (_file == NULL) {
+        throw DBException("Can't create sort run");
+    }
+}
+
+SortRun::~SortRun()
+{
+    fclose(_file);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+class Row;
+
+// A run of rows spilled by a Sort to a temporary file, (which is deleted when the run is). Rows are written, and
+// then read back in the same order, as intermediate rows, along with the codes and native forms of their values.
+class SortRun
+{
+public:
+    void write(const Row* row);
+
+    // Start reading the rows written
+    void rewind();
+
+    // The next row, or NULL following the last
+    Row* read();
+
+    // Throws DBException if the temporary file can't be created
+    SortRun();
+
+    ~SortRun();
+
+private:
+    FILE* _file;
+};
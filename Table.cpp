@@ -1,12 +1,59 @@
 #include <cstring>
 #include <cassert>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "Table.h"
 #include "Index.h"
+#include "HashIndex.h"
+#include "Parallel.h"
 #include "Row.h"
+#include "Database.h"
 #include "dbexceptions.h"
 
 using namespace std;
 
+const unsigned Table::LOAD_BATCH_SIZE;
+
+// Append the CSV field starting at p to row, and return the position following it: a comma, a line end, or end.
+static const char* parse_csv_field(const char* p, const char* end, Row* row)
+{
+    if (p < end && *p == '"') {
+        // Only a field containing escaped quotes is assembled in a separate string.
+        string unescaped;
+        bool escaped = false;
+        const char* quote;
+        p++;
+        while (true) {
+            quote = (const char*) memchr(p, '"', end - p);
+            if (quote == NULL) {
+                throw TableException("Unterminated quoted field");
+            }
+            if (quote + 1 < end && quote[1] == '"') {
+                unescaped.append(p, quote + 1 - p);
+                escaped = true;
+                p = quote + 2;
+            } else {
+                break;
+            }
+        }
+        if (escaped) {
+            unescaped.append(p, quote - p);
+            row->append(unescaped);
+        } else {
+            row->append(p, quote - p);
+        }
+        return quote + 1;
+    }
+    const char* start = p;
+    while (p < end && *p != ',' && *p != '\n' && *p != '\r') {
+        p++;
+    }
+    row->append(start, p - start);
+    return p;
+}
+
 const string &Table::name() const
 {
     return _name;
@@ -17,12 +64,172 @@ const ColumnNames &Table::columns() const
     return _columns;
 }
 
+TableStorage Table::storage() const
+{
+    return _storage;
+}
+
 RowList& Table::rows()
 {
     return _rows;
 }
 
+unsigned long Table::n_rows() const
+{
+    return _storage == ROW_STORAGE ? _rows.size() : _column_values.at(0).size();
+}
+
+const Column &Table::column(unsigned position) const
+{
+    assert(_storage == COLUMN_STORAGE);
+    return _column_values.at(position);
+}
+
 void Table::add(Row* row)
+{
+    check(row);
+    store(row);
+    for (Index* index : _indexes) {
+        index->put(index->key(row), row);
+    }
+    for (HashIndex* index : _hash_indexes) {
+        index->put(index->key(row), row);
+    }
+}
+
+void Table::add(const RowList& rows)
+{
+    // Every row is checked before any value is added to the Dictionary.
+    for (Row* row : rows) {
+        check(row);
+    }
+    for (Row* row : rows) {
+        store(row);
+    }
+    // Only ROW_STORAGE tables have indexes, so the rows are still present.
+    for (Index* index : _indexes) {
+        index->put(rows);
+    }
+    for (HashIndex* index : _hash_indexes) {
+        index->reserve(index->size() + rows.size());
+        for (Row* row : rows) {
+            index->put(index->key(row), row);
+        }
+    }
+}
+
+void Table::load_csv(const string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat file_status;
+    if (fd < 0 || fstat(fd, &file_status) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw TableException("Can't open " + path);
+    }
+    size_t size = (size_t) file_status.st_size;
+    void* mapped = size == 0 ? NULL : mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw TableException("Can't map " + path);
+    }
+    if (mapped != NULL) {
+        madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    const char* p = (const char*) mapped;
+    const char* end = p + size;
+    RowList rows;
+    try {
+        while (p < end) {
+            if (*p == '\n' || *p == '\r') {
+                p++;
+                continue;
+            }
+            Row* row = new Row(this);
+            rows.emplace_back(row);
+            row->reserve(_columns.size());
+            p = parse_csv_field(p, end, row);
+            while (p < end && *p == ',') {
+                p = parse_csv_field(p + 1, end, row);
+            }
+            if (p < end && *p != '\n' && *p != '\r') {
+                throw TableException("Malformed line in " + path);
+            }
+            if (rows.size() == LOAD_BATCH_SIZE) {
+                add(rows);
+                rows.clear();
+            }
+        }
+        add(rows);
+    } catch (...) {
+        for (Row* row : rows) {
+            delete row;
+        }
+        if (mapped != NULL) {
+            munmap(mapped, size);
+        }
+        throw;
+    }
+    if (mapped != NULL) {
+        munmap(mapped, size);
+    }
+}
+
+Index* Table::add_index(const ColumnNames& index_columns, unsigned n_threads)
+{
+    Index* index = new Index(this, index_key_columns(index_columns));
+    index->put(_rows, n_threads);
+    _indexes.emplace_back(index);
+    return index;
+}
+
+vector<Index*> Table::add_indexes(const vector<ColumnNames>& indexes_columns, unsigned n_threads)
+{
+    vector<Index*> indexes;
+    for (const ColumnNames& index_columns : indexes_columns) {
+        indexes.emplace_back(new Index(this, index_key_columns(index_columns)));
+    }
+    // Threads are divided evenly among the indexes, each index getting at least one. With fewer threads than
+    // indexes, each thread builds several indexes in turn, one thread apiece, so no more than n_threads are used.
+    unsigned n = (unsigned) indexes.size();
+    parallel_for(n, max(1U, min(n, n_threads)), [&](unsigned long begin, unsigned long end) {
+        for (unsigned long i = begin; i < end; i++) {
+            unsigned index_threads = max(1UL, (n_threads * (i + 1)) / n - (n_threads * i) / n);
+            indexes[i]->put(_rows, index_threads);
+        }
+    });
+    _indexes.insert(_indexes.end(), indexes.begin(), indexes.end());
+    return indexes;
+}
+
+HashIndex* Table::add_hash_index(const ColumnNames& index_columns)
+{
+    HashIndex* index = new HashIndex(this, index_key_columns(index_columns));
+    index->reserve(_rows.size());
+    for (Row* row : _rows) {
+        index->put(index->key(row), row);
+    }
+    _hash_indexes.emplace_back(index);
+    return index;
+}
+
+void Table::dictionary_encode(const ColumnNames& columns)
+{
+    if (_storage != COLUMN_STORAGE) {
+        throw TableException("Dictionary encoding requires column storage");
+    }
+    Dictionary* dictionary = Database::dictionary();
+    for (const string& column : columns) {
+        int position = _columns.position(column);
+        if (position == -1) {
+            throw TableException("Unknown column");
+        }
+        _column_values.at((unsigned) position).encode(dictionary);
+    }
+}
+
+void Table::check(Row* row)
 {
     const ColumnNames& source_columns = row->table()->columns();
     const ColumnNames& target_columns = _columns;
@@ -32,35 +239,48 @@ void Table::add(Row* row)
     if (source_columns.size() != target_columns.size()) {
         throw TableException("source and target metadata incompatible");
     }
-    _rows.emplace_back(row);
+    unsigned n = (unsigned) _columns.size();
+    if (_columns.typed()) {
+        for (unsigned i = 0; i < n; i++) {
+            ColumnType type = _columns.type(i);
+            if (type != STRING_COLUMN) {
+                row->set_native(i, native_value(type, row->at(i)));
+            }
+        }
+    }
+}
+
+void Table::store(Row* row)
+{
+    if (_storage == ROW_STORAGE) {
+        _rows.emplace_back(row);
+    } else {
+        unsigned n = (unsigned) _columns.size();
+        for (unsigned i = 0; i < n; i++) {
+            _column_values[i].append(row->at(i), row->native(i));
+        }
+        delete row;
+    }
 }
 
-Index* Table::add_index(const ColumnNames& index_columns)
+vector<unsigned> Table::index_key_columns(const ColumnNames& index_columns) const
 {
-    Index* index = new Index(this);
-    unsigned n_key_columns = (unsigned) index_columns.size();
-    unsigned key_positions[n_key_columns];
-    unsigned k = 0;
+    if (_storage != ROW_STORAGE) {
+        throw TableException("Indexes require row storage");
+    }
+    vector<unsigned> key_positions;
     for (const string& column : index_columns) {
         int position = _columns.position(column);
         assert(position != -1);
-        key_positions[k++] = (unsigned) position;
-    }
-    vector<string> key;
-    for (Row* row : _rows) {
-        key.clear();
-        for (unsigned i = 0; i < n_key_columns; i++) {
-            key.emplace_back(row->at(key_positions[i]));
-        }
-        index->put(key, row);
+        key_positions.emplace_back((unsigned) position);
     }
-    _indexes.emplace_back(index);
-    return index;
+    return key_positions;
 }
 
-Table::Table(const string &name, const ColumnNames &columns)
+Table::Table(const string &name, const ColumnNames &columns, TableStorage storage)
     : _name(name),
-      _columns(columns)
+      _columns(columns),
+      _storage(storage)
 {
     if (columns.empty()) {
         throw TableException("No columns");
@@ -73,6 +293,11 @@ Table::Table(const string &name, const ColumnNames &columns)
             }
         }
     }
+    if (_storage == COLUMN_STORAGE) {
+        for (unsigned i = 0; i < n; i++) {
+            _column_values.emplace_back(columns.type(i));
+        }
+    }
 }
 
 Table::~Table()
@@ -80,6 +305,9 @@ Table::~Table()
     for (Index* index : _indexes) {
         delete index;
     }
+    for (HashIndex* index : _hash_indexes) {
+        delete index;
+    }
     auto i = _rows.begin();
     while (i != _rows.end()) {
         delete *i;
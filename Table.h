@@ -4,10 +4,21 @@
 #include <set>
 #include "Row.h"
 #include "ColumnNames.h"
+#include "Column.h"
 
 using namespace std;
 
 class Index;
+class HashIndex;
+
+// How a Table stores its rows. ROW_STORAGE keeps each Row. COLUMN_STORAGE keeps one Column per attribute, so that
+// a scan reads only the columns it needs. Rows of a COLUMN_STORAGE table are only materialized by scans, (as
+// intermediate rows), so rows() is empty and indexes are not supported.
+enum TableStorage
+{
+    ROW_STORAGE,
+    COLUMN_STORAGE
+};
 
 class Table
 {
@@ -18,26 +29,81 @@ public:
     // The columns of this Table
     const ColumnNames &columns() const;
 
+    // How this Table stores its rows
+    TableStorage storage() const;
+
     // The contents of this Table
     RowList& rows();
 
-    // Add the given row to the table, returning true if the row was added, false if not (because a matching row
-    // is already present). Following a successful add (i.e., returning true), the row is owned by the table, and
-    // must not be modified or deleted by the caller. Otherwise, it is the caller's responsibility to delete the row
-    // eventually.
+    // The number of rows in this Table
+    unsigned long n_rows() const;
+
+    // The values of the column at the given position. Only for COLUMN_STORAGE.
+    const Column &column(unsigned position) const;
+
+    // Add the given row to the table, which then owns it: the caller must not modify or delete it. The row is
+    // rejected by throwing TableException if it has the wrong number of values, or a value of a typed column is
+    // malformed; the row is then not added, nothing is added to the Database's Dictionary, and the caller remains
+    // responsible for deleting the row. Native forms of typed values, and codes of dictionary-encoded values, are
+    // recorded. Indexes of the table are updated.
     void add(Row* row);
 
-    Index* add_index(const ColumnNames& index_columns);
+    // Add the given rows, as for add(Row*). Each index is updated once, for all the rows, which is faster than
+    // adding them one at a time. Every row is checked before any is added, so if any row is rejected, (by
+    // throwing TableException), then none are added, and the Dictionary is unchanged.
+    void add(const RowList& rows);
+
+    // Add the rows of the given CSV file, one per line, as for add(const RowList&). Fields are separated by commas,
+    // and may be enclosed in double quotes, (within which "" stands for one double quote). Blank lines are skipped,
+    // so an empty value of a one-column table must be written as "". The file is mapped into memory and parsed in a
+    // single pass, with each field copied once, into its Row. Rows are added in batches of LOAD_BATCH_SIZE, so if a
+    // line is rejected, (by throwing TableException), the rows of preceding batches remain. Throws TableException if
+    // the file can't be read, or is malformed.
+    void load_csv(const string& path);
+
+    // Add an ordered index on the given columns, using n_threads threads to extract and sort the keys of the
+    // rows present. Only for ROW_STORAGE.
+    Index* add_index(const ColumnNames& index_columns, unsigned n_threads = 1);
+
+    // Add an ordered index on each of the given lists of columns, as for add_index. The indexes are built
+    // concurrently, each on its own threads, using n_threads threads in all.
+    vector<Index*> add_indexes(const vector<ColumnNames>& indexes_columns, unsigned n_threads);
+
+    // Add an index supporting lookups of complete keys only, (see HashIndex). Only for ROW_STORAGE.
+    HashIndex* add_hash_index(const ColumnNames& index_columns);
+
+    // Encode the given columns using the Database's Dictionary, for rows present and rows added later. The columns
+    // then store just the codes, saving memory for columns with few distinct values, and equality of scanned
+    // values, (in joins, selections and duplicate elimination), compares codes instead of strings. Only for
+    // COLUMN_STORAGE: a Row keeps its own copy of each value, so encoding would not shrink a ROW_STORAGE table.
+    void dictionary_encode(const ColumnNames& columns);
 
     // Create a table with the given name and column names
-    Table(const string& name, const ColumnNames& columns);
+    Table(const string& name, const ColumnNames& columns, TableStorage storage = ROW_STORAGE);
 
     // Destroy this table
     ~Table();
 
+public:
+    static const unsigned LOAD_BATCH_SIZE = 10000;
+
+private:
+    // Check the given row, and set the native forms of its values, throwing TableException if the row can't be
+    // added
+    void check(Row* row);
+
+    // Take ownership of a checked row
+    void store(Row* row);
+
+    // Positions of the given columns, for a new index
+    vector<unsigned> index_key_columns(const ColumnNames& index_columns) const;
+
 private:
     string _name;
     ColumnNames _columns;
+    TableStorage _storage;
     RowList _rows;
+    vector<Column> _column_values;
     vector<Index*> _indexes;
+    vector<HashIndex*> _hash_indexes;
 };
@@ -1,4 +1,3 @@
-#include <fstream>
 #include <cassert>
 #include "Database.h"
 #include "unittest.h"
@@ -9,61 +8,56 @@ using namespace std;
 static char *db_dir;
 
 static Table *user;
+static Table *user_columns;
 static Index* username_index;
 static Table *routing;
 static Table *message;
+static Table *routing_columns;
+static Table *message_columns;
 
 // ------------------------------------------------------------------------------------------
 
 // Loading the database from .csv files
 
-static string strip_eol(string line)
-{
-    char c;
-    int remove = 0;
-    while ((c = line.at(line.size() - 1 - remove)) == '\r' || c == '\n') {
-        remove++;
-    }
-    return line.substr(0, line.size() - remove);
-}
-
 static void load_table(Table *table, string db_dir, const string &filename)
 {
     if (db_dir.at(db_dir.size() - 1) != '/') {
         db_dir += '/';
     }
-    string user_path = db_dir + filename;
-    ifstream input(user_path);
-    string line;
-    if (input.is_open()) {
-        while (getline(input, line)) {
-            line = strip_eol(line);
-            vector<string> fields;
-            size_t start_scan = 0;
-            bool done = false;
-            while (!done) {
-                size_t after_field = line.find(',', start_scan + 1);
-                if (after_field == string::npos) {
-                    done = true;
-                    after_field = line.size();
-                }
-                string field = line.substr(start_scan + 1, after_field - 2 - start_scan); // Skips quote marks
-                fields.emplace_back(field);
-                start_scan = after_field + 1;
-            }
-            add(table, fields);
-        }
-    } else {
-        fprintf(stderr, "Can't open %s?!\n", user_path.c_str());
+    try {
+        table->load_csv(db_dir + filename);
+    } catch (TableException& e) {
+        fprintf(stderr, "%s?!\n", e.what());
     }
 }
 
 static void import(const char *db_dir)
 {
-    user = Database::new_table("user", ColumnNames{"user_id", "username", "birth_date"});
-    routing = Database::new_table("routing", ColumnNames{"from_user_id", "to_user_id", "message_id"});
-    message = Database::new_table("message", ColumnNames{"message_id", "send_date", "text"});
+    user = Database::new_table("user",
+                               ColumnNames({"user_id", "username", "birth_date"},
+                                           {INTEGER_COLUMN, STRING_COLUMN, DATE_COLUMN}));
+    routing = Database::new_table("routing",
+                                  ColumnNames({"from_user_id", "to_user_id", "message_id"},
+                                              {INTEGER_COLUMN, INTEGER_COLUMN, INTEGER_COLUMN}));
+    message = Database::new_table("message",
+                                  ColumnNames({"message_id", "send_date", "text"},
+                                              {INTEGER_COLUMN, DATE_COLUMN, STRING_COLUMN}));
+    user_columns = Database::new_table("user_columns",
+                                       ColumnNames{"user_id", "username", "birth_date"},
+                                       COLUMN_STORAGE);
     load_table(user, db_dir, "user.csv");
+    routing_columns = Database::new_table("routing_columns",
+                                          ColumnNames{"from_user_id", "to_user_id", "message_id"},
+                                          COLUMN_STORAGE);
+    message_columns = Database::new_table("message_columns",
+                                          ColumnNames{"message_id", "send_date", "text"},
+                                          COLUMN_STORAGE);
+    user_columns->dictionary_encode(ColumnNames{"user_id", "username"});
+    routing_columns->dictionary_encode(ColumnNames{"from_user_id", "to_user_id"});
+    message_columns->dictionary_encode(ColumnNames{"send_date"});
+    load_table(user_columns, db_dir, "user.csv");
+    load_table(routing_columns, db_dir, "routing.csv");
+    load_table(message_columns, db_dir, "message.csv");
     load_table(routing, db_dir, "routing.csv");
     load_table(message, db_dir, "message.csv");
     username_index = user->add_index(ColumnNames{"username"});
@@ -104,6 +98,38 @@ static void test_q1()
     delete c1;
 }
 
+static Iterator* q1_pipeline(Iterator* input)
+{
+    return project(select(input, q1_predicate), {2});
+}
+
+static void test_q1_parallel_scan()
+{
+    Table *control1 = Database::new_table("control1_parallel_scan", ColumnNames{"birth_date"});
+    add(control1, {"1984/02/28"});
+    Iterator* q1 = parallel_scan(user, 4, q1_pipeline, 1000);
+    Iterator* c1 = table_scan(control1);
+    CHECK(match(c1, q1));
+    delete q1;
+    delete c1;
+}
+
+static bool q1_value_predicate(const string& username)
+{
+    return username == "Tweetii";
+}
+
+static void test_q1_column_scan()
+{
+    Table *control1 = Database::new_table("control1_column_scan", ColumnNames{"birth_date"});
+    add(control1, {"1984/02/28"});
+    Iterator* q1 = column_scan(user_columns, {2}, 1, q1_value_predicate);
+    Iterator* c1 = table_scan(control1);
+    CHECK(match(c1, q1));
+    delete q1;
+    delete c1;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 
 // What are the send dates of messages sent by Zyrianyhippy?
@@ -155,6 +181,90 @@ static void test_q2_table_scan()
     delete c2;
 }
 
+static void test_q2_equality_by_code()
+{
+    Table *control2 = Database::new_table("control2_equality_by_code", ColumnNames{"send_date"});
+    add(control2, {"2015/01/09"});
+    add(control2, {"2015/04/29"});
+    add(control2, {"2015/12/25"});
+    add(control2, {"2016/01/08"});
+    add(control2, {"2016/02/09"});
+    add(control2, {"2016/02/22"});
+    add(control2, {"2016/03/25"});
+    add(control2, {"2016/04/26"});
+    add(control2, {"2016/09/05"});
+    add(control2, {"2016/10/08"});
+    add(control2, {"2017/01/10"});
+    add(control2, {"2017/06/07"});
+    add(control2, {"2017/08/05"});
+    Iterator* c2 = table_scan(control2);
+    // user_columns.username is dictionary-encoded, so the selection compares codes.
+    Iterator* q2 =
+        unique(
+            sort(
+                project(
+                    nested_loops_join(
+                        nested_loops_join(
+                            select(table_scan(user_columns), 1, "Zyrianyhippy"),
+                            {0},
+                            table_scan(routing),
+                            {0}
+                        ),
+                        {4},
+                        table_scan(message),
+                        {0}
+                    ),
+                {5}),
+            {0})
+        )
+        ;
+    CHECK(match(c2, q2));
+    delete q2;
+    delete c2;
+}
+
+static void test_q2_hash_distinct()
+{
+    Table *control2 = Database::new_table("control2_hash_distinct", ColumnNames{"send_date"});
+    add(control2, {"2015/01/09"});
+    add(control2, {"2015/04/29"});
+    add(control2, {"2015/12/25"});
+    add(control2, {"2016/01/08"});
+    add(control2, {"2016/02/09"});
+    add(control2, {"2016/02/22"});
+    add(control2, {"2016/03/25"});
+    add(control2, {"2016/04/26"});
+    add(control2, {"2016/09/05"});
+    add(control2, {"2016/10/08"});
+    add(control2, {"2017/01/10"});
+    add(control2, {"2017/06/07"});
+    add(control2, {"2017/08/05"});
+    Iterator* c2 = table_scan(control2);
+    // Duplicates are eliminated before sorting, so only the distinct send dates are sorted.
+    Iterator* q2 =
+        sort(
+            hash_distinct(
+                project(
+                    nested_loops_join(
+                        nested_loops_join(
+                            (select(table_scan(user), q2_predicate)),
+                            {0},
+                            table_scan(routing),
+                            {0}
+                        ),
+                        {4},
+                        table_scan(message),
+                        {0}
+                    ),
+                {5})
+            ),
+        {0})
+        ;
+    CHECK(match(c2, q2));
+    delete q2;
+    delete c2;
+}
+
 static void test_q2_index_scan()
 {
     Table *control2 = Database::new_table("control2_index_scan", ColumnNames{"send_date"});
@@ -199,6 +309,216 @@ static void test_q2_index_scan()
     delete c2;
 }
 
+static void test_q2_hash_index_scan()
+{
+    Table *control2 = Database::new_table("control2_hash_index_scan", ColumnNames{"send_date"});
+    add(control2, {"2015/01/09"});
+    add(control2, {"2015/04/29"});
+    add(control2, {"2015/12/25"});
+    add(control2, {"2016/01/08"});
+    add(control2, {"2016/02/09"});
+    add(control2, {"2016/02/22"});
+    add(control2, {"2016/03/25"});
+    add(control2, {"2016/04/26"});
+    add(control2, {"2016/09/05"});
+    add(control2, {"2016/10/08"});
+    add(control2, {"2017/01/10"});
+    add(control2, {"2017/06/07"});
+    add(control2, {"2017/08/05"});
+    Iterator* c2 = table_scan(control2);
+    Row username({"Zyrianyhippy"});
+    HashIndex* tc = user->add_hash_index(ColumnNames{"username"});
+    Iterator* q2 =
+        unique(
+            sort(
+                project(
+                    nested_loops_join(
+                        nested_loops_join(
+                            hash_index_scan(tc, &username),
+                            {0},
+                            table_scan(routing),
+                            {0}
+                        ),
+                        {4},
+                        table_scan(message),
+                        {0}
+                    ),
+                {5}),
+            {0})
+        )
+        ;
+    CHECK(match(c2, q2));
+    delete q2;
+    delete c2;
+}
+
+static void test_q2_hash_join()
+{
+    Table *control2 = Database::new_table("control2_hash_join", ColumnNames{"send_date"});
+    add(control2, {"2015/01/09"});
+    add(control2, {"2015/04/29"});
+    add(control2, {"2015/12/25"});
+    add(control2, {"2016/01/08"});
+    add(control2, {"2016/02/09"});
+    add(control2, {"2016/02/22"});
+    add(control2, {"2016/03/25"});
+    add(control2, {"2016/04/26"});
+    add(control2, {"2016/09/05"});
+    add(control2, {"2016/10/08"});
+    add(control2, {"2017/01/10"});
+    add(control2, {"2017/06/07"});
+    add(control2, {"2017/08/05"});
+    Iterator* c2 = table_scan(control2);
+    Iterator* q2 =
+        unique(
+            sort(
+                project(
+                    hash_join(
+                        hash_join(
+                            (select(table_scan(user), q2_predicate)),
+                            {0},
+                            table_scan(routing),
+                            {0}
+                        ),
+                        {4},
+                        table_scan(message),
+                        {0}
+                    ),
+                {5}),
+            {0})
+        )
+        ;
+    CHECK(match(c2, q2));
+    delete q2;
+    delete c2;
+}
+
+static void test_q2_merge_join()
+{
+    Table *control2 = Database::new_table("control2_merge_join", ColumnNames{"send_date"});
+    add(control2, {"2015/01/09"});
+    add(control2, {"2015/04/29"});
+    add(control2, {"2015/12/25"});
+    add(control2, {"2016/01/08"});
+    add(control2, {"2016/02/09"});
+    add(control2, {"2016/02/22"});
+    add(control2, {"2016/03/25"});
+    add(control2, {"2016/04/26"});
+    add(control2, {"2016/09/05"});
+    add(control2, {"2016/10/08"});
+    add(control2, {"2017/01/10"});
+    add(control2, {"2017/06/07"});
+    add(control2, {"2017/08/05"});
+    Iterator* c2 = table_scan(control2);
+    Iterator* q2 =
+        unique(
+            sort(
+                project(
+                    merge_join(
+                        sort(
+                            merge_join(
+                                sort(select(table_scan(user), q2_predicate), {0}),
+                                {0},
+                                sort(table_scan(routing), {0}),
+                                {0}
+                            ),
+                        {4}),
+                        {4},
+                        sort(table_scan(message), {0}),
+                        {0}
+                    ),
+                {5}),
+            {0})
+        )
+        ;
+    CHECK(match(c2, q2));
+    delete q2;
+    delete c2;
+}
+
+static void test_q2_index_join()
+{
+    Table *control2 = Database::new_table("control2_index_join", ColumnNames{"send_date"});
+    add(control2, {"2015/01/09"});
+    add(control2, {"2015/04/29"});
+    add(control2, {"2015/12/25"});
+    add(control2, {"2016/01/08"});
+    add(control2, {"2016/02/09"});
+    add(control2, {"2016/02/22"});
+    add(control2, {"2016/03/25"});
+    add(control2, {"2016/04/26"});
+    add(control2, {"2016/09/05"});
+    add(control2, {"2016/10/08"});
+    add(control2, {"2017/01/10"});
+    add(control2, {"2017/06/07"});
+    add(control2, {"2017/08/05"});
+    Iterator* c2 = table_scan(control2);
+    Row username({"Zyrianyhippy"});
+    Index* from_user_id_index = routing->add_index(ColumnNames{"from_user_id"});
+    Index* message_id_index = message->add_index(ColumnNames{"message_id"});
+    Iterator* q2 =
+        unique(
+            sort(
+                project(
+                    index_join(
+                        index_join(
+                            index_scan(username_index, &username),
+                            {0},
+                            from_user_id_index
+                        ),
+                        {4},
+                        message_id_index
+                    ),
+                {5}),
+            {0})
+        )
+        ;
+    CHECK(match(c2, q2));
+    delete q2;
+    delete c2;
+}
+
+static void test_q2_dictionary_encoded()
+{
+    Table *control2 = Database::new_table("control2_dictionary_encoded", ColumnNames{"send_date"});
+    add(control2, {"2015/01/09"});
+    add(control2, {"2015/04/29"});
+    add(control2, {"2015/12/25"});
+    add(control2, {"2016/01/08"});
+    add(control2, {"2016/02/09"});
+    add(control2, {"2016/02/22"});
+    add(control2, {"2016/03/25"});
+    add(control2, {"2016/04/26"});
+    add(control2, {"2016/09/05"});
+    add(control2, {"2016/10/08"});
+    add(control2, {"2017/01/10"});
+    add(control2, {"2017/06/07"});
+    add(control2, {"2017/08/05"});
+    Iterator* c2 = table_scan(control2);
+    Iterator* q2 =
+        unique(
+            sort(
+                project(
+                    nested_loops_join(
+                        nested_loops_join(
+                            column_scan(user_columns, {0, 1, 2}, 1, "Zyrianyhippy"),
+                            {0},
+                            table_scan(routing_columns),
+                            {0}
+                        ),
+                        {4},
+                        table_scan(message_columns),
+                        {0}
+                    ),
+                {5}),
+            {0})
+        )
+        ;
+    CHECK(match(c2, q2));
+    delete q2;
+    delete c2;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 
 // What are the usernames of members who received messages on their birthdays?
@@ -239,6 +559,37 @@ static void test_q3()
     delete c3;
 }
 
+static void test_q3_block_nested_loops_join()
+{
+    Table *control3 = Database::new_table("control3_block_nested_loops_join", ColumnNames{"username"});
+    add(control3, {"Moneyocracy"});
+    Iterator *q3 =
+        project(
+            select(
+                block_nested_loops_join(
+                    block_nested_loops_join(
+                        table_scan(user),
+                        {0},
+                        table_scan(routing),
+                        {1},
+                        8
+                    ),
+                    {4},
+                    table_scan(message),
+                    {0},
+                    256
+                ),
+                q3_predicate
+            ),
+            {1}
+        )
+        ;
+    Iterator* c3 = table_scan(control3);
+    CHECK(match(c3, q3));
+    delete q3;
+    delete c3;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 
 // What are the send dates of messages from Unguiferous to Froglet?
@@ -295,6 +646,48 @@ static void test_q4()
     delete c4;
 }
 
+// Each thread joins its share of routing to the other tables.
+static Iterator* q4_pipeline(Iterator* routing_rows)
+{
+    return
+        project(
+            hash_join(
+                hash_join(
+                    hash_join(
+                        project(
+                            select(table_scan(user), q4_from_predicate),
+                            {0}
+                        ),
+                        {0},
+                        routing_rows,
+                        {0}
+                    ),
+                    {1},
+                    project(
+                        select(table_scan(user), q4_to_predicate),
+                        {0}
+                    ),
+                    {0}
+                ),
+                {2},
+                table_scan(message),
+                {0}
+            ),
+            {3}
+        );
+}
+
+static void test_q4_exchange()
+{
+    Table *control4 = Database::new_table("control4_exchange", ColumnNames{"send_date"});
+    add(control4, {"2016/12/14"});
+    Iterator *q4 = exchange(table_scan(routing), 4, q4_pipeline);
+    Iterator* c4 = table_scan(control4);
+    CHECK(match(c4, q4));
+    delete q4;
+    delete c4;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 
 void test_queries(int argc, const char **argv)
@@ -307,10 +700,21 @@ void test_queries(int argc, const char **argv)
     BEFORE_ALL_TESTS(setup);
     AFTER_ALL_TESTS(reset_database);
     ADD_TEST(test_q1);
+    ADD_TEST(test_q1_column_scan);
+    ADD_TEST(test_q1_parallel_scan);
     ADD_TEST(test_q2_table_scan);
+    ADD_TEST(test_q2_equality_by_code);
+    ADD_TEST(test_q2_hash_distinct);
     ADD_TEST(test_q2_index_scan);
+    ADD_TEST(test_q2_hash_index_scan);
+    ADD_TEST(test_q2_hash_join);
+    ADD_TEST(test_q2_merge_join);
+    ADD_TEST(test_q2_index_join);
+    ADD_TEST(test_q2_dictionary_encoded);
     ADD_TEST(test_q3);
+    ADD_TEST(test_q3_block_nested_loops_join);
     ADD_TEST(test_q4);
+    ADD_TEST(test_q4_exchange);
     RUN_TESTS();
     free(db_dir);
 }
@@ -3,6 +3,7 @@
 #include "dbexceptions.h"
 #include "Table.h"
 #include "Iterator.h"
+#include "Row.h"
 
 TestRow::TestRow(Table* table, const vector<string>& values)
     : Row(table)
@@ -54,9 +55,7 @@ bool row_eq(const vector<string>* x, const vector<string>& y)
 
 void done_with(Row* row)
 {
-    if (row->is_intermediate_row()) {
-        delete row;
-    }
+    Row::reclaim(row);
 }
 
 bool match(Iterator* x, Iterator* y)
@@ -87,6 +86,42 @@ bool match(Iterator* x, Iterator* y)
     return match;
 }
 
+// Like match, but reads y using next_batch
+bool match_batches(Iterator* x, Iterator* y, unsigned batch_size)
+{
+    bool match = true;
+    if (x == NULL || y == NULL) {
+        match = false;
+    } else if (x->n_columns() != y->n_columns()) {
+        match = false;
+    } else {
+        x->open();
+        y->open();
+        RowBatch batch(batch_size);
+        Row* x_row = x->next();
+        while (match && y->next_batch(batch) > 0) {
+            match = batch.size() <= batch_size;
+            for (Row* y_row : batch) {
+                if (x_row == NULL || !row_eq(x_row, y_row)) {
+                    match = false;
+                }
+                if (x_row != NULL) {
+                    done_with(x_row);
+                    x_row = x->next();
+                }
+                done_with(y_row);
+            }
+        }
+        match = match && x_row == NULL;
+        if (x_row != NULL) {
+            done_with(x_row);
+        }
+        x->close();
+        y->close();
+    }
+    return match;
+}
+
 void print_iterator(const char* label, Iterator* input)
 {
     printf("%s:\n", label);
@@ -16,6 +16,7 @@ bool row_eq(const vector<string>* x, const vector<string>* y);
 bool row_eq(const vector<string>* x, const vector<string>& y);
 void done_with(Row* row);
 bool match(Iterator* x, Iterator* y);
+bool match_batches(Iterator* x, Iterator* y, unsigned batch_size);
 void print_iterator(const char* label, Iterator* input);
 
 #define IMPLEMENT_ME 0